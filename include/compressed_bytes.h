@@ -0,0 +1,71 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#ifndef __COMPRESSED_BYTES_H_INCLUDED__
+#define __COMPRESSED_BYTES_H_INCLUDED__
+
+#include "types.h"
+#include <cstddef>
+#include <vector>
+
+namespace easydbuspp {
+
+/*!
+ * A byte array that is zlib-compressed on the wire when it is large enough for that to pay off
+ * (JSON, logs, ...). The D-Bus type is `(yay)`: an encoding byte (0 for raw, 1 for zlib) followed by
+ * the bytes. Compression happens when the value is marshalled and decompression when it is decoded,
+ * so both ends just see the original bytes. Method arguments of this type are annotated with
+ * `org.easydbuspp.Compression` in the introspection data.
+ */
+class compressed_bytes {
+
+public:
+    //! Payloads smaller than this are sent as they are, unless told otherwise.
+    static constexpr size_t DEFAULT_THRESHOLD = 1024;
+
+    //! An empty array.
+    compressed_bytes() = default;
+
+    //! Payloads of at least `threshold` bytes get compressed (if that actually makes them smaller).
+    explicit compressed_bytes(std::vector<std::byte> bytes, size_t threshold = DEFAULT_THRESHOLD)
+        : bytes_ {std::move(bytes)}, threshold_ {threshold}
+    {
+    }
+
+    //! The uncompressed bytes.
+    const std::vector<std::byte>& bytes() const { return bytes_; }
+
+    //! Moves the uncompressed bytes out.
+    std::vector<std::byte> release() { return std::move(bytes_); }
+
+    const std::byte* data() const { return bytes_.data(); }
+    size_t           size() const { return bytes_.size(); }
+    bool             empty() const { return bytes_.empty(); }
+
+    auto begin() const { return bytes_.begin(); }
+    auto end() const { return bytes_.end(); }
+
+private:
+    // Returns a floating (yay) GVariant.
+    GVariant* encode() const;
+
+    // Decodes a (yay) GVariant, inflating the payload if needed.
+    //
+    // @throw std::runtime_error
+    static compressed_bytes decode(GVariant* v);
+
+    template <typename T>
+    friend std::decay_t<T> from_gvariant(GVariant* v);
+
+    template <typename T>
+    friend GVariant* to_gvariant(const T& t);
+
+private:
+    std::vector<std::byte> bytes_;
+    size_t                 threshold_ {DEFAULT_THRESHOLD};
+};
+
+} // end of namespace easydbuspp
+
+#endif // __COMPRESSED_BYTES_H_INCLUDED__
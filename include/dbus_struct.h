@@ -0,0 +1,58 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#ifndef __DBUS_STRUCT_H_INCLUDED__
+#define __DBUS_STRUCT_H_INCLUDED__
+
+#include <tuple>
+
+/*!
+ * Lets a plain struct be used wherever a `std::tuple` could, as a D-Bus struct made of the listed
+ * members (in the order given). Use it in the namespace the struct lives in, after the struct:
+ *
+ * ```cpp
+ * struct track {
+ *     std::string title;
+ *     uint32_t    length;
+ * };
+ *
+ * EASYDBUSPP_STRUCT(track, title, length)
+ * ```
+ *
+ * The D-Bus type of `track` is then `(su)`, and values are (de)serialized member by member without going
+ * through a tuple. Up to 16 members are supported. Decoding needs the struct to be default constructible.
+ */
+#define EASYDBUSPP_STRUCT(type, ...)                                                                              \
+    [[maybe_unused]] constexpr auto easydbuspp_struct_members(const type*)                                        \
+    {                                                                                                             \
+        return std::make_tuple(                                                                                   \
+            EASYDBUSPP_STRUCT_CAT(EASYDBUSPP_MEMBERS_, EASYDBUSPP_STRUCT_COUNT(__VA_ARGS__))(type, __VA_ARGS__)); \
+    }
+
+// Implementation details of EASYDBUSPP_STRUCT() below.
+
+#define EASYDBUSPP_STRUCT_CAT(a, b) EASYDBUSPP_STRUCT_CAT_(a, b)
+#define EASYDBUSPP_STRUCT_CAT_(a, b) a##b
+#define EASYDBUSPP_STRUCT_COUNT(...) \
+    EASYDBUSPP_STRUCT_COUNT_(__VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define EASYDBUSPP_STRUCT_COUNT_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, N, ...) N
+
+#define EASYDBUSPP_MEMBERS_1(t, m) &t::m
+#define EASYDBUSPP_MEMBERS_2(t, m, ...) &t::m, EASYDBUSPP_MEMBERS_1(t, __VA_ARGS__)
+#define EASYDBUSPP_MEMBERS_3(t, m, ...) &t::m, EASYDBUSPP_MEMBERS_2(t, __VA_ARGS__)
+#define EASYDBUSPP_MEMBERS_4(t, m, ...) &t::m, EASYDBUSPP_MEMBERS_3(t, __VA_ARGS__)
+#define EASYDBUSPP_MEMBERS_5(t, m, ...) &t::m, EASYDBUSPP_MEMBERS_4(t, __VA_ARGS__)
+#define EASYDBUSPP_MEMBERS_6(t, m, ...) &t::m, EASYDBUSPP_MEMBERS_5(t, __VA_ARGS__)
+#define EASYDBUSPP_MEMBERS_7(t, m, ...) &t::m, EASYDBUSPP_MEMBERS_6(t, __VA_ARGS__)
+#define EASYDBUSPP_MEMBERS_8(t, m, ...) &t::m, EASYDBUSPP_MEMBERS_7(t, __VA_ARGS__)
+#define EASYDBUSPP_MEMBERS_9(t, m, ...) &t::m, EASYDBUSPP_MEMBERS_8(t, __VA_ARGS__)
+#define EASYDBUSPP_MEMBERS_10(t, m, ...) &t::m, EASYDBUSPP_MEMBERS_9(t, __VA_ARGS__)
+#define EASYDBUSPP_MEMBERS_11(t, m, ...) &t::m, EASYDBUSPP_MEMBERS_10(t, __VA_ARGS__)
+#define EASYDBUSPP_MEMBERS_12(t, m, ...) &t::m, EASYDBUSPP_MEMBERS_11(t, __VA_ARGS__)
+#define EASYDBUSPP_MEMBERS_13(t, m, ...) &t::m, EASYDBUSPP_MEMBERS_12(t, __VA_ARGS__)
+#define EASYDBUSPP_MEMBERS_14(t, m, ...) &t::m, EASYDBUSPP_MEMBERS_13(t, __VA_ARGS__)
+#define EASYDBUSPP_MEMBERS_15(t, m, ...) &t::m, EASYDBUSPP_MEMBERS_14(t, __VA_ARGS__)
+#define EASYDBUSPP_MEMBERS_16(t, m, ...) &t::m, EASYDBUSPP_MEMBERS_15(t, __VA_ARGS__)
+
+#endif // __DBUS_STRUCT_H_INCLUDED__
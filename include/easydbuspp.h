@@ -8,11 +8,24 @@
 // Convenience header.
 
 #include "bus_watcher.h"
+#include "compressed_bytes.h"
+#include "dbus_struct.h"
 #include "idle_detector.h"
+#include "interface_definition.h"
+#include "lazy.h"
 #include "main_loop.h"
 #include "object.h"
+#include "object_manager.h"
+#include "object_manager_client.h"
 #include "org_freedesktop_dbus_proxy.h"
+#include "peer_server.h"
+#include "property_cell.h"
 #include "proxy.h"
+#include "request_arena.h"
 #include "session_manager.h"
+#include "session_shards.h"
+#include "shared_buffer.h"
+#include "signal_subscription.h"
+#include "stream.h"
 
 #endif // __EASYSBUSPP_H_INCLUDED__
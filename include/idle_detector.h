@@ -5,20 +5,33 @@
 #ifndef __IDLE_DETECTOR_H_INCLUDED__
 #define __IDLE_DETECTOR_H_INCLUDED__
 
+#include "timer_wheel.h"
 #include "types.h"
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <functional>
 #include <future>
 #include <mutex>
-#include <set>
+#include <unordered_map>
 
 namespace easydbuspp {
 
 class object;
 
+//! Per-object idle detector bookkeeping. Every object has one, so that pings don't need a lookup.
+struct idle_state {
+    std::atomic<bool>                           exempt {false};
+    std::atomic<bool>                           watched {false};
+    std::atomic<std::chrono::steady_clock::rep> last_activity {0};
+};
+
 /*!
  * When no requests have come to the managed object in a specified timeframe,
  * this class will shut the main loop down if it is running.
+ *
+ * Separately, individual objects can be watched with their own timeouts (e.g. to get rid of per-client
+ * objects nobody uses anymore). All watched objects share a single thread, driving a timer wheel.
  */
 class idle_detector {
 
@@ -47,23 +60,69 @@ public:
     //! Stops the idle detector thread, if it's running.
     void disable();
 
-    //! Resets the timeout. Every time this function gets called, the timer resets to timeout again.
-    void ping(const object_path_t& object_path);
+    /*!
+     * Resets the timeout. Every time this function gets called, the timer resets to timeout again.
+     * This only records the time of the request (no locking, no waking up the idle detector thread),
+     * so it's cheap enough to call on every request.
+     *
+     * @param obj The object that got the request. Pings from excluded objects are ignored.
+     */
+    void ping(const object& obj);
 
     //! Don't reset the timeout on pings from this object.
     void exclude(const object& obj);
 
+    /*!
+     * Call `on_idle` once `obj` goes `timeout` without any requests. This is independent of `enable()`
+     * (and of `exclude()`): the application keeps running, only the callback gets called. Once called,
+     * the object is no longer watched. Watching an already watched object replaces its timeout and
+     * callback. Timeouts have a resolution of WHEEL_TICK.
+     *
+     * @param obj     The object to watch. Destroying the object stops watching it.
+     * @param timeout How long the object needs to be idle for.
+     * @param on_idle Called from the idle detector's thread, so it must not block for long. It's fine
+     *                for it to destroy `obj`.
+     */
+    template <typename Rep, typename Period>
+    void watch(const object& obj, const std::chrono::duration<Rep, Period>& timeout, std::function<void()> on_idle);
+
+    //! Stop watching `obj`. Does nothing if it's not being watched.
+    void unwatch(const object& obj);
+
 public:
     //! Return the unique, per-process instance.
     static idle_detector& instance();
 
+    //! Resolution of per-object timeouts.
+    static constexpr std::chrono::milliseconds WHEEL_TICK {50};
+
+private:
+    struct watched_object {
+        std::chrono::steady_clock::duration timeout;
+        std::function<void()>               on_idle;
+        timer_wheel<const object*>::handle  timer;
+    };
+
+    void watch_for(const object& obj, std::chrono::steady_clock::duration timeout, std::function<void()> on_idle);
+    void wheel_loop();
+
+    static std::chrono::steady_clock::rep now();
+    static uint64_t                       to_ticks(std::chrono::steady_clock::rep timestamp);
+
 private:
-    std::condition_variable idle_cv_;
-    std::mutex              idle_mutex_;
-    bool                    request_ping_ {false};
-    bool                    stop_ {false};
-    std::future<void>       idle_future_;
-    std::set<object_path_t> excluded_objects_;
+    std::condition_variable                      idle_cv_;
+    std::mutex                                   idle_mutex_;
+    bool                                         stop_ {false};
+    std::future<void>                            idle_future_;
+    std::atomic<bool>                            enabled_ {false};
+    std::atomic<std::chrono::steady_clock::rep> last_activity_ {0};
+
+    std::condition_variable                           wheel_cv_;
+    std::mutex                                        wheel_mutex_;
+    bool                                              wheel_stop_ {false};
+    std::future<void>                                 wheel_future_;
+    timer_wheel<const object*>                        wheel_;
+    std::unordered_map<const object*, watched_object> watched_objects_;
 };
 
 } // end of namespace easydbuspp
@@ -17,26 +17,40 @@ void idle_detector::enable(const std::chrono::duration<Rep, Period>& timeout)
         throw std::runtime_error("Idle detector already running!");
 
     stop_ = false;
+    last_activity_.store(now(), std::memory_order_relaxed);
+    enabled_.store(true, std::memory_order_relaxed);
+
+    const auto idle_timeout = std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout);
+
+    idle_future_ = std::async(std::launch::async, [this, idle_timeout] {
+        std::unique_lock lock {idle_mutex_};
 
-    idle_future_ = std::async(std::launch::async, [this, timeout] {
         for (;;) {
-            std::unique_lock lock {idle_mutex_};
+            const auto last_activity = last_activity_.load(std::memory_order_relaxed);
+            const std::chrono::steady_clock::time_point deadline {
+                std::chrono::steady_clock::duration {last_activity} + idle_timeout};
+
+            // Pings don't wake us up, so sleep until the deadline and then see if there's been one since.
+            if (idle_cv_.wait_until(lock, deadline, [this] {
+                    return stop_;
+                }))
+                return;
 
-            if (!idle_cv_.wait_for(lock, timeout, [this] {
-                    return request_ping_ || stop_;
-                })) {
+            if (last_activity_.load(std::memory_order_relaxed) == last_activity) {
                 main_loop::instance().stop();
                 return;
-            } else {
-                request_ping_ = false;
-
-                if (stop_)
-                    return;
             }
         }
     });
 }
 
+template <typename Rep, typename Period>
+void idle_detector::watch(const object& obj, const std::chrono::duration<Rep, Period>& timeout,
+                          std::function<void()> on_idle)
+{
+    watch_for(obj, std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout), std::move(on_idle));
+}
+
 } // end of namespace easydbuspp
 
 #endif // __IDLE_DETECTOR_INL_INCLUDED__
@@ -0,0 +1,151 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#ifndef __INTERFACE_DEFINITION_H_INCLUDED__
+#define __INTERFACE_DEFINITION_H_INCLUDED__
+
+#include "params.h"
+#include "type_mapping.h"
+#include "types.h"
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace easydbuspp {
+
+class object;
+
+/*!
+ * The methods, properties and signals of a D-Bus interface, independent of any object path.
+ *
+ * Every `object` has one of these, built up by its `add_method()`, `add_property()`, etc. calls. But a
+ * definition can also be built on its own, and then shared by any number of objects (see the matching
+ * `object` constructor). All of them then use the same handlers and the same parsed introspection data,
+ * so 100000 objects implementing the same interface cost one definition. Handlers tell the objects apart
+ * by the `dbus_context` they're called with: its `object_path`, and its `state`, which is whatever
+ * pointer the object was constructed with.
+ *
+ * A definition can't change once an object using it is on the bus (its `add_*()` calls throw then).
+ */
+class interface_definition {
+
+public:
+    using method_handler_t
+        = std::function<std::pair<GVariant*, GUnixFDList*>(GVariant*, GUnixFDList*, const dbus_context&)>;
+    using property_read_handler_t  = std::function<GVariant*(const dbus_context&)>;
+    using property_write_handler_t = std::function<gboolean(GVariant*, const dbus_context&)>;
+
+public:
+    /*!
+     * Constructor.
+     *
+     * @param name The interface name (e.g. "net.my_domain.my_host.widget_interface").
+     */
+    explicit interface_definition(const std::string& name);
+
+    interface_definition& operator=(const interface_definition&) = delete;
+
+    //! Same as `object::add_method()`.
+    template <typename C>
+    void add_method(const std::string& name, C&& callable, const std::vector<std::string>& in_argument_names = {},
+                    const std::vector<std::string>& out_argument_names = {});
+
+    //! Same as `object::add_property()`. Note that all objects sharing the definition share `value`.
+    template <typename T>
+    void add_property(const std::string& name, T&& value);
+
+    //! Same as `object::add_property()`.
+    template <typename T>
+    void add_property(const std::string& name, const std::function<T()>& getter,
+                      const std::function<bool(const T&)>& setter);
+
+    //! Same as `object::add_property()`.
+    template <typename T>
+    void add_property(const std::string& name, const std::function<T(const dbus_context&)>& getter,
+                      const std::function<bool(const dbus_context&, const T&)>& setter);
+
+    /*!
+     * Same as `object::add_broadcast_signal()`, except that the returned function takes the object to
+     * emit the signal from as its first parameter.
+     */
+    template <typename... A>
+    std::function<void(const object&, A...)> add_broadcast_signal(const std::string&              name,
+                                                                  const std::vector<std::string>& argument_names = {});
+
+    /*!
+     * Same as `object::add_unicast_signal()`, except that the returned function takes the object to
+     * emit the signal from as its first parameter.
+     */
+    template <typename... A>
+    std::function<void(const object&, const std::string&, A...)>
+    add_unicast_signal(const std::string& name, const std::vector<std::string>& argument_names = {});
+
+    //! Returns the interface name.
+    std::string name() const;
+
+    //! Returns the introspection XML of the interface (a complete `<node>`).
+    std::string introspection_xml() const;
+
+private:
+    // Copies the handlers and XML, but not the frozen state (see object::change_own_interface()).
+    interface_definition(const interface_definition& other);
+
+    // Parses the introspection XML, which freezes the definition: from then on, the tables and the XML
+    // can be read without locking, and changing them throws. The returned pointer belongs to the definition.
+    GDBusInterfaceInfo* interface_info() const;
+
+    bool frozen() const;
+
+    // These lock introspection_mutex_, and throw if the definition is frozen.
+    void add_method_entry(const std::string& name, method_handler_t handler, const std::string& method_xml);
+    void add_property_entry(const std::string& name, property_read_handler_t read_handler,
+                            property_write_handler_t write_handler, const std::string& type, const char* access);
+    void add_signal_entry(const std::string& signal_xml);
+
+    // Callers hold introspection_mutex_.
+    std::string build_introspection_xml() const;
+    void        throw_if_frozen() const;
+
+    template <typename T>
+    static std::string method_arg_xml(const std::string& name, const char* direction);
+
+    template <typename R, size_t... I>
+    static std::string method_out_args_xml(const std::vector<std::string>& out_argument_names,
+                                           std::index_sequence<I...>);
+
+    template <typename C, typename R, typename... A>
+    method_handler_t add_method_helper(const std::string& name, C&& callable, const std::function<R(A...)>&,
+                                       const std::vector<std::string>& in_argument_names,
+                                       const std::vector<std::string>& out_argument_names, std::string& method_xml);
+
+    template <typename... A>
+    std::function<void(const object&, const std::string&, A...)>
+    add_signal(const std::string& name, bool unicast, const std::vector<std::string>& argument_names);
+
+    // Defined out of line, where object is a complete type. Takes ownership of (floating) `parameters`.
+    static void emit_signal(const object& obj, const std::string& interface_name, const std::string& signal_name,
+                            const char* destination, GVariant* parameters);
+
+private:
+    std::string                                                                                   name_;
+    std::string                                                                                   methods_xml_;
+    std::string                                                                                   properties_xml_;
+    std::string                                                                                   signals_xml_;
+    std::unordered_map<std::string, method_handler_t>                                             methods_;
+    std::unordered_map<std::string, std::pair<property_read_handler_t, property_write_handler_t>> properties_;
+    mutable std::mutex                                                                            introspection_mutex_;
+    mutable g_dbus_node_info_ptr                                                                  introspection_data_;
+    mutable bool                                                                                  frozen_ {false};
+
+    friend class object;
+};
+
+} // end of namespace easydbuspp
+
+#include "interface_definition.inl"
+
+#endif // __INTERFACE_DEFINITION_H_INCLUDED__
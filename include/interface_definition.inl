@@ -0,0 +1,259 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#ifndef __INTERFACE_DEFINITION_INL_INCLUDED__
+#define __INTERFACE_DEFINITION_INL_INCLUDED__
+
+#include <memory>
+#include <stdexcept>
+
+namespace easydbuspp {
+
+template <typename T>
+std::string interface_definition::method_arg_xml(const std::string& name, const char* direction)
+{
+    std::string arg_xml {"   <arg name='" + name + "' type='" + to_dbus_type_string<T>() + "' direction='" + direction
+                         + "'"};
+    std::string annotations = dbus_annotations_xml<T>();
+
+    if (annotations.empty())
+        return arg_xml + "/>\n";
+
+    return arg_xml + ">\n" + annotations + "   </arg>\n";
+}
+
+template <typename R, size_t... I>
+std::string interface_definition::method_out_args_xml(const std::vector<std::string>& out_argument_names,
+                                                      std::index_sequence<I...>)
+{
+    return (std::string {} + ...
+            + method_arg_xml<std::tuple_element_t<I, R>>(
+                out_argument_names.empty() ? "out_arg" + std::to_string(I) : out_argument_names[I], "out"));
+}
+
+template <typename C, typename R, typename... A>
+interface_definition::method_handler_t
+interface_definition::add_method_helper(const std::string& name, C&& callable, const std::function<R(A...)>&,
+                                        const std::vector<std::string>& in_argument_names,
+                                        const std::vector<std::string>& out_argument_names, std::string& method_xml)
+{
+    if constexpr (!std::is_void_v<R>) {
+        if constexpr (is_tuple_like_v<R>) {
+            if (!out_argument_names.empty() && out_argument_names.size() != std::tuple_size_v<R>)
+                throw std::runtime_error("Method '" + name
+                                         + "': number of out argument names does not match output tuple size!");
+        } else if (!out_argument_names.empty() && out_argument_names.size() != 1)
+            throw std::runtime_error("Method '" + name + "': too many out argument names!");
+    }
+
+    size_t arg_index {0};
+
+    method_xml = "  <method name='" + name + "'>\n";
+
+    (
+        [&]() {
+            if constexpr (!std::is_same_v<std::decay_t<A>, dbus_context>) {
+                std::string arg_name = "in_arg" + std::to_string(arg_index);
+
+                if (!in_argument_names.empty()) {
+                    if (arg_index == in_argument_names.size())
+                        throw std::runtime_error("Method '" + name + "': too few input argument names provided!");
+                    arg_name = in_argument_names[arg_index];
+                }
+
+                method_xml += method_arg_xml<A>(arg_name, "in");
+
+                ++arg_index;
+            }
+        }(),
+        ...);
+
+    if (!in_argument_names.empty() && in_argument_names.size() != arg_index)
+        throw std::runtime_error("Method '" + name
+                                 + "': number of input argument names does not match number of arguments!");
+
+    if constexpr (!std::is_void_v<R>) {
+        if constexpr (is_tuple_like_v<R>)
+            method_xml += method_out_args_xml<R>(out_argument_names, std::make_index_sequence<std::tuple_size_v<R>> {});
+        else
+            method_xml
+                += method_arg_xml<R>(out_argument_names.empty() ? "out_arg0" : out_argument_names[0], "out");
+    }
+
+    method_xml += "  </method>\n";
+
+    return [callable = std::forward<C>(callable)](GVariant* parameters, GUnixFDList* fd_list,
+                                                  const dbus_context& context) {
+        // Declared first, so that it outlives everything decoded into (or built in) the arena.
+        request_arena_scope arena_scope;
+        gsize               arg_index {0};
+
+        [[maybe_unused]] auto init = [parameters, &arg_index, &context](auto* type_tag) {
+            using arg_t = std::remove_pointer_t<decltype(type_tag)>;
+
+            if constexpr (std::is_same_v<arg_t, dbus_context>)
+                return context;
+            else
+                return extract<arg_t>(parameters, arg_index++);
+        };
+
+        // Initialize the tuple in place (braced initialization runs init() in argument order).
+        std::tuple<std::decay_t<A>...> fn_args {init(static_cast<std::decay_t<A>*>(nullptr))...};
+
+        set_up_from_g_unix_fd_list(fd_list, fn_args);
+
+        // The decoded arguments are ours, so by-value parameters get them moved in.
+        auto invoke = [&callable, &fn_args] {
+            return std::apply(
+                [&callable](auto&... args) {
+                    return callable(std::forward<A>(args)...);
+                },
+                fn_args);
+        };
+
+        if constexpr (!std::is_void_v<R>) {
+            if constexpr (is_tuple_like_v<R>) {
+                auto ret         = invoke();
+                auto out_fd_list = extract_g_unix_fd_list(ret);
+                return std::pair {to_gvariant(ret), out_fd_list};
+            } else {
+                auto wrapper     = std::tuple {invoke()};
+                auto out_fd_list = extract_g_unix_fd_list(wrapper);
+                return std::pair {to_gvariant(wrapper), out_fd_list};
+            }
+        } else {
+            invoke();
+            return std::pair {nullptr, nullptr};
+        }
+    };
+}
+
+template <typename C>
+void interface_definition::add_method(const std::string& name, C&& callable,
+                                      const std::vector<std::string>& in_argument_names,
+                                      const std::vector<std::string>& out_argument_names)
+{
+    using std_function_type = decltype(std::function {std::forward<C>(callable)});
+
+    std::string method_xml;
+    auto        handler = add_method_helper(name, std::forward<C>(callable), std_function_type {}, in_argument_names,
+                                            out_argument_names, method_xml);
+
+    add_method_entry(name, std::move(handler), method_xml);
+}
+
+template <typename... A>
+std::function<void(const object&, A...)>
+interface_definition::add_broadcast_signal(const std::string& name, const std::vector<std::string>& argument_names)
+{
+    auto ret = add_signal<A...>(name, false, argument_names);
+
+    return [ret](const object& obj, A... args) {
+        ret(obj, "", std::move(args)...);
+    };
+}
+
+template <typename... A>
+std::function<void(const object&, const std::string&, A...)>
+interface_definition::add_unicast_signal(const std::string& name, const std::vector<std::string>& argument_names)
+{
+    return add_signal<A...>(name, true, argument_names);
+}
+
+template <typename... A>
+std::function<void(const object&, const std::string&, A...)>
+interface_definition::add_signal(const std::string& name, bool unicast, const std::vector<std::string>& argument_names)
+{
+    if (!argument_names.empty() && argument_names.size() != sizeof...(A))
+        throw std::runtime_error("Signal '" + name
+                                 + "': number of in argument names does not match number of arguments!");
+
+    std::string signal_xml {"  <signal name='" + name + "'>\n"};
+
+    int arg_index = 0;
+
+    ((signal_xml += "   <arg type='" + to_dbus_type_string<A>() + "' name='"
+          + (argument_names.empty() ? "arg" + std::to_string(arg_index++) : argument_names[arg_index++]) + "'/>\n"),
+     ...);
+
+    signal_xml += "  </signal>\n";
+    add_signal_entry(signal_xml);
+
+    return [interface_name = name_, name, unicast](const object& obj, const std::string& bus_name, A... args) {
+        std::tuple<marshalled_arg_t<A>...> fn_args {args...};
+
+        emit_signal(obj, interface_name, name, unicast ? bus_name.c_str() : nullptr, to_gvariant(fn_args));
+    };
+}
+
+template <typename T>
+void interface_definition::add_property(const std::string& name, T&& value)
+{
+    if constexpr (!is_output_type_v<T>) {
+        // The value can't change, so it only needs to be marshalled once.
+        std::shared_ptr<GVariant> cached_value {g_variant_ref_sink(to_gvariant(value)), g_variant_unref};
+
+        add_property_entry(
+            name,
+            [cached_value](const dbus_context&) {
+                return g_variant_ref(cached_value.get());
+            },
+            {}, to_dbus_type_string<T>(), "read");
+    } else {
+        add_property_entry(
+            name,
+            [&value](const dbus_context&) {
+                return to_gvariant(value);
+            },
+            [&value](GVariant* new_value, const dbus_context&) {
+                value = from_gvariant<T>(new_value);
+                return TRUE;
+            },
+            to_dbus_type_string<T>(), "readwrite");
+    }
+}
+
+template <typename T>
+void interface_definition::add_property(const std::string& name, const std::function<T()>& getter,
+                                        const std::function<bool(const T&)>& setter)
+{
+    std::function<T(const dbus_context&)>              context_getter;
+    std::function<bool(const dbus_context&, const T&)> context_setter;
+
+    if (getter)
+        context_getter = [getter](const dbus_context&) {
+            return getter();
+        };
+
+    if (setter)
+        context_setter = [setter](const dbus_context&, const T& value) {
+            return setter(value);
+        };
+
+    add_property<T>(name, context_getter, context_setter);
+}
+
+template <typename T>
+void interface_definition::add_property(const std::string& name, const std::function<T(const dbus_context&)>& getter,
+                                        const std::function<bool(const dbus_context&, const T&)>& setter)
+{
+    if (!setter && !getter)
+        throw std::runtime_error("Property '" + name + "': needs to provide at least a setter or a getter!");
+
+    auto read_lambda = [getter](const dbus_context& context) {
+        return to_gvariant(getter(context));
+    };
+
+    auto write_lambda = [setter](GVariant* new_value, const dbus_context& context) -> gboolean {
+        return setter(context, from_gvariant<T>(new_value));
+    };
+
+    add_property_entry(name, getter ? read_lambda : property_read_handler_t {},
+                       setter ? write_lambda : property_write_handler_t {}, to_dbus_type_string<T>(),
+                       !setter ? "read" : !getter ? "write" : "readwrite");
+}
+
+} // end of namespace easydbuspp
+
+#endif // __INTERFACE_DEFINITION_INL_INCLUDED__
@@ -0,0 +1,64 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#ifndef __LAZY_H_INCLUDED__
+#define __LAZY_H_INCLUDED__
+
+#include "params.h"
+#include "types.h"
+#include <cstddef>
+#include <optional>
+
+namespace easydbuspp {
+
+/*!
+ * A method parameter that is only decoded when (and as much as) it is used. It has the same D-Bus
+ * type as `T`, but holds on to the received GVariant instead of converting it up front. The whole
+ * value is decoded (once) on the first call to `get()`, while `size()`, `at()` and `find()` decode
+ * single array elements or dictionary values without materializing the rest.
+ *
+ * Like the other method parameters, a lazy<T> belongs to the invocation it was received with, so it
+ * is not meant to be shared between threads.
+ */
+template <typename T>
+class lazy {
+
+public:
+    using value_type = T;
+
+    lazy() = default;
+
+    //! Takes ownership of a reference to `value`, which must have the D-Bus type of `T`.
+    explicit lazy(GVariant* value);
+
+    //! Decodes the whole value on first use, then returns the cached result.
+    const T& get() const;
+
+    const T& operator*() const { return get(); }
+    const T* operator->() const { return &get(); }
+
+    //! The undecoded value (no reference is transferred to the caller).
+    GVariant* gvariant() const { return value_.get(); }
+
+    //! Number of elements of an array or dictionary, without decoding any of them.
+    size_t size() const;
+
+    //! Decodes only the `index`th element of an array.
+    template <typename U = T>
+    typename U::value_type at(size_t index) const;
+
+    //! Decodes only the value stored under `key` in a dictionary, if there is one.
+    template <typename U = T>
+    std::optional<typename U::mapped_type> find(const typename U::key_type& key) const;
+
+private:
+    raw_variant              value_;
+    mutable std::optional<T> decoded_;
+};
+
+} // end of namespace easydbuspp
+
+#include "lazy.inl"
+
+#endif // __LAZY_H_INCLUDED__
@@ -0,0 +1,98 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#ifndef __LAZY_INL_INCLUDED__
+#define __LAZY_INL_INCLUDED__
+
+#include <stdexcept>
+
+namespace easydbuspp {
+
+template <typename T>
+lazy<T>::lazy(GVariant* value) : value_ {value}
+{
+}
+
+template <typename T>
+const T& lazy<T>::get() const
+{
+    if (!decoded_) {
+        if (!value_)
+            throw std::runtime_error("Can't decode an empty lazy<T>!");
+
+        decoded_ = from_gvariant<T>(value_.get());
+    }
+
+    return *decoded_;
+}
+
+template <typename T>
+size_t lazy<T>::size() const
+{
+    static_assert(is_vector_v<T> || is_map_like_v<T>, "lazy<T>::size() needs an array or dictionary T");
+
+    if (decoded_)
+        return decoded_->size();
+
+    return value_ ? g_variant_n_children(value_.get()) : 0;
+}
+
+template <typename T>
+template <typename U>
+typename U::value_type lazy<T>::at(size_t index) const
+{
+    static_assert(is_vector_v<T>, "lazy<T>::at() needs an array T");
+
+    if (decoded_)
+        return decoded_->at(index);
+
+    if (index >= size())
+        throw std::out_of_range("lazy<T>::at(): index " + std::to_string(index) + " is out of range!");
+
+    g_variant_ptr element {g_variant_get_child_value(value_.get(), index), g_variant_unref};
+
+    return from_gvariant<typename U::value_type>(element.get());
+}
+
+template <typename T>
+template <typename U>
+std::optional<typename U::mapped_type> lazy<T>::find(const typename U::key_type& key) const
+{
+    static_assert(is_map_like_v<T>, "lazy<T>::find() needs a dictionary T");
+
+    if (decoded_) {
+        auto it = decoded_->find(key);
+
+        if (it == decoded_->end())
+            return std::nullopt;
+
+        return it->second;
+    }
+
+    const size_t entries = size();
+
+    for (size_t i = 0; i < entries; ++i) {
+        g_variant_ptr entry {g_variant_get_child_value(value_.get(), i), g_variant_unref};
+        g_variant_ptr entry_key {g_variant_get_child_value(entry.get(), 0), g_variant_unref};
+
+        bool found {false};
+
+        // String keys (by far the most common, e.g. 'a{sv}') are compared in place.
+        if constexpr (decay_same_v<typename U::key_type, std::string>)
+            found = key == g_variant_get_string(entry_key.get(), nullptr);
+        else
+            found = key == from_gvariant<typename U::key_type>(entry_key.get());
+
+        if (found) {
+            g_variant_ptr entry_value {g_variant_get_child_value(entry.get(), 1), g_variant_unref};
+            return from_gvariant<typename U::mapped_type>(entry_value.get());
+        }
+    }
+
+    return std::nullopt;
+}
+
+} // end of namespace easydbuspp
+
+#endif // __LAZY_INL_INCLUDED__
@@ -6,12 +6,21 @@
 #define __OBJECT_H_INCLUDED__
 
 #include "g_thread_pool.h"
+#include "idle_detector.h"
+#include "interface_definition.h"
 #include "params.h"
+#include "property_cell.h"
 #include "type_mapping.h"
 #include "types.h"
+#include <atomic>
+#include <chrono>
 #include <cstdlib>
 #include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <utility>
+#include <vector>
 
 namespace easydbuspp {
 
@@ -24,10 +33,8 @@ class session_manager;
  */
 class object {
 
-    using method_handler_t
-        = std::function<std::pair<GVariant*, GUnixFDList*>(GVariant*, GUnixFDList*, const dbus_context&)>;
-    using property_read_handler_t  = std::function<GVariant*()>;
-    using property_write_handler_t = std::function<gboolean(GVariant*)>;
+    using property_read_handler_t  = interface_definition::property_read_handler_t;
+    using property_write_handler_t = interface_definition::property_write_handler_t;
 
 public:
     //! Used in (optional) pre-request handlers.
@@ -36,6 +43,12 @@ public:
     //! Type to which all pre-request handler callbacks must conform.
     using pre_request_handler_t = std::function<void(request_type, const dbus_context&)>;
 
+    //! Tells a subtree object whether it has a child with the given name (the last element of its path).
+    using lookup_child_t = std::function<bool(const std::string& child)>;
+
+    //! Lists the names of a subtree object's children (only used for introspection).
+    using enumerate_children_t = std::function<std::vector<std::string>()>;
+
 public:
     /*!
      * Constructor.
@@ -49,6 +62,63 @@ public:
      */
     object(session_manager& session_mgr, const std::string& interface_name, const object_path_t& object_path);
 
+    /*!
+     * Constructor for a subtree object. Instead of being a single D-Bus object, this registers the
+     * interface for all the direct children of `object_path` at once, without needing an `object`
+     * (or even a registration) per child. Children are resolved when requests come in for them, by
+     * calling `lookup_child`, so there can be any number of them.
+     * Method handlers can tell which child a request is for by taking a `dbus_context` parameter
+     * (its `object_path` is the child's path), and properties can be added with getters and setters
+     * that take one too.
+     *
+     * @param session_mgr        This object is responsible for establishing and maintaining the D-Bus
+     *                           connection.
+     * @param interface_name     The name of the interface every child implements.
+     * @param object_path        The parent path of the children (e.g. "/net/my_domain/widgets", for
+     *                           "/net/my_domain/widgets/<child>" objects).
+     * @param lookup_child       Returns true if a child with the given name exists. Requests for
+     *                           children it returns false for fail with an "unknown object" error.
+     * @param enumerate_children (Optional) Lists the children, for introspection. If missing,
+     *                           introspecting `object_path` won't show any children, but they are
+     *                           still reachable.
+     */
+    object(session_manager& session_mgr, const std::string& interface_name, const object_path_t& object_path,
+           const lookup_child_t& lookup_child, const enumerate_children_t& enumerate_children = {});
+
+    /*!
+     * Constructor for an object implementing a shared interface_definition. The object has no methods,
+     * properties or signals of its own: it serves the definition's, and its `add_method()`,
+     * `add_property()`, `add_broadcast_signal()` and `add_unicast_signal()` throw.
+     *
+     * @param session_mgr This object is responsible for establishing and maintaining the D-Bus connection.
+     * @param definition  The interface. It can be shared by any number of objects.
+     * @param object_path The object path that will uniquely identify this object.
+     * @param state       (Optional) Passed to the definition's handlers as the `state` member of their
+     *                    `dbus_context`, so that they know which object they're working on.
+     */
+    object(session_manager& session_mgr, std::shared_ptr<const interface_definition> definition,
+           const object_path_t& object_path, void* state = nullptr);
+
+    /*!
+     * Serve another interface from this object (from all of its children, for a subtree object). The
+     * added interface's handlers get the same `dbus_context::state` as those of the object's own
+     * interface. If the object is already on the bus, the interface is registered soon after (from the
+     * dispatch context), and any object_manager above the object emits `InterfacesAdded` then.
+     *
+     * @param definition The interface. It can be shared with other objects.
+     * @throw            std::runtime_error
+     */
+    void add_interface(std::shared_ptr<const interface_definition> definition);
+
+    /*!
+     * Stop serving an interface added with `add_interface()`. Any object_manager above the object emits
+     * `InterfacesRemoved`.
+     *
+     * @param interface_name The name of the interface.
+     * @throw                std::runtime_error
+     */
+    void remove_interface(const std::string& interface_name);
+
     //! Destructor. If applicable, will disconnect the object from its D-Bus connection.
     ~object();
 
@@ -90,6 +160,20 @@ public:
     template <typename T>
     void add_property(const std::string& name, T&& value);
 
+    /*!
+     * Add a readwrite property backed by a property_cell (generates XML introspection data as well).
+     * Unlike a plain variable, the cell can be read and updated by application threads while the object
+     * serves requests. The cell must outlive the object, and can only back one property at a time.
+     *
+     * @param name         The name of the property, as displayed when introspecting the D-Bus object.
+     * @param cell         The property's value.
+     * @param emit_changes (Optional) If true, `cell.store()` emits a `PropertiesChanged` signal with the
+     *                     new value. Changes made over D-Bus always emit it.
+     * @throw              std::runtime_error
+     */
+    template <typename T>
+    void add_property(const std::string& name, property_cell<T>& cell, bool emit_changes = false);
+
     /*!
      * Add a property (generates XML introspection data as well). This will create a read, readwrite,
      * or write-only property depending on which callback is being passed in. Default (uninitialized)
@@ -106,6 +190,18 @@ public:
     void add_property(const std::string& name, const std::function<T()>& getter,
                       const std::function<bool(const T&)>& setter);
 
+    /*!
+     * Same as the getter / setter `add_property()` above, except that the callbacks also get the
+     * `dbus_context` of the request (useful for subtree objects, whose children share properties).
+     *
+     * @param name   The name of the property, as displayed when introspecting the D-Bus object.
+     * @param getter Anything taking a `const dbus_context&` and returning a `T`.
+     * @param setter Anything taking a `const dbus_context&` and a `const T&`, and returning a `bool`.
+     */
+    template <typename T>
+    void add_property(const std::string& name, const std::function<T(const dbus_context&)>& getter,
+                      const std::function<bool(const dbus_context&, const T&)>& setter);
+
     /*!
      * Add a broadcast signal (generates XML introspection data as well). Broadcast signals are sent to
      * everybody, on all buses. A signal may have parameters, so when you receive one you may also get
@@ -160,28 +256,137 @@ public:
      */
     void pre_request_handler(const pre_request_handler_t& handler);
 
-    //! Returns this object's interface name.
+    /*!
+     * Batch property change notifications. Instead of a `PropertiesChanged` signal per change, changes
+     * are collected for `window` (or until `flush_property_changes()`) and then sent in a single signal,
+     * which only carries the latest value of each property. A zero window, the default, turns batching
+     * off: every change gets its own signal, right away.
+     *
+     * @param window How long to wait, after a first change, before sending the batched signal.
+     */
+    void coalesce_property_changes(std::chrono::milliseconds window);
+
+    //! Sends the `PropertiesChanged` signal for the changes batched so far, if any, right away.
+    void flush_property_changes();
+
+    /*!
+     * Ignore property writes that don't change anything. When enabled, an incoming value is compared
+     * (with `g_variant_equal()`) to the current one, as returned by the property's getter, or to the last
+     * value written, for write-only properties. If they're equal, the setter is not called and no
+     * `PropertiesChanged` signal is emitted. Disabled by default.
+     *
+     * @param skip Whether to skip unchanged writes.
+     */
+    void skip_unchanged_property_writes(bool skip = true);
+
+    /*!
+     * Cache the marshalled values of readable properties, so that repeated `Get` / `GetAll` requests don't
+     * call the getter (and convert its result to a GVariant) each time. A cached value is dropped when the
+     * property is set over D-Bus, or when `invalidate_property_value()` is called. Values of read-only
+     * properties added with a constant value are always cached, regardless of this setting.
+     * Disabled by default, and ignored by subtree objects (whose children's values differ). Only applies to
+     * the properties of the interface the object was constructed with.
+     *
+     * @param cache Whether to cache property values.
+     */
+    void cache_property_values(bool cache = true);
+
+    /*!
+     * Drop the cached value of a property, if any. Call this after changing a property's value from outside
+     * its D-Bus setter (e.g. by assigning to the variable bound with `add_property()`), if property values
+     * are being cached. Getters must not call this.
+     *
+     * @param name The name of the property.
+     */
+    void invalidate_property_value(const std::string& name);
+
+    //! Returns this object's interface name (that of the interface it was constructed with).
     std::string interface_name() const;
 
+    //! Returns the names of all the interfaces this object serves, starting with `interface_name()`.
+    std::vector<std::string> interface_names() const;
+
     //! Returns this object's unique object path.
     object_path_t object_path() const;
 
 private:
-    std::string introspection_xml() const;
+    // Doesn't attach to the session_manager, so that the public constructors can finish setting up first.
+    object(session_manager& session_mgr, const object_path_t& object_path,
+           std::shared_ptr<interface_definition> own_definition);
 
-    void connect();
-    void disconnect();
+    // Registers whatever isn't registered yet (and the own interface again, if it's changed since). Returns the
+    // interfaces that weren't on the bus before.
+    std::vector<std::shared_ptr<const interface_definition>> connect();
+    void                                                     disconnect();
 
-    template <typename C, typename R, typename... A>
-    method_handler_t add_method_helper(const std::string& name, C&& callable, const std::function<R(A...)>&,
-                                       const std::vector<std::string>& in_argument_names,
-                                       const std::vector<std::string>& out_argument_names);
+    // Registers a single interface at object_path_ (for non-subtree objects).
+    void register_interface(const std::shared_ptr<const interface_definition>& definition);
 
-    template <typename... A>
-    std::function<void(const std::string&, A...)> add_signal(const std::string& name, bool unicast,
-                                                             const std::vector<std::string>& argument_names);
+    // Registers the changes made to the object from the dispatch context, all those made before it gets to run at
+    // once.
+    void schedule_registration();
+
+    // Connects the object (if the session is), and announces what that changed.
+    void sync_registration();
+
+    // Makes the latest own definition (frozen from then on) the one the object serves.
+    void publish_own_interface();
+
+    // Returns the definition of `interface_name`, or nullptr if this object doesn't serve it.
+    std::shared_ptr<const interface_definition> find_interface(const std::string& interface_name) const;
 
-    void emit_properties_update_signal(const std::string& property_name, GVariant* value) const;
+    std::vector<std::shared_ptr<const interface_definition>> interfaces() const;
+
+    bool registered() const;
+
+    // Runs the subtree's lookup function. A lookup that throws is logged, and the child treated as nonexistent.
+    bool child_exists(const std::string& node) const;
+
+    // Adds the object's paths (those of its enumerable children, for a subtree object) to `managed_objects`,
+    // as seen by `sender`.
+    void managed_objects(std::map<object_path_t, interfaces_and_properties_t>& managed_objects,
+                         const std::string&                                    sender) const;
+
+    // Reads all the readable properties of `definitions`, for the object at `object_path`.
+    interfaces_and_properties_t
+    interfaces_and_properties(const object_path_t&                                            object_path,
+                              const std::vector<std::shared_ptr<const interface_definition>>& definitions,
+                              const std::string&                                              sender) const;
+
+    // Applies `change` to the definition add_method(), add_property(), etc. add to, then refreshes the registration.
+    // A definition that's being served is frozen, so the change goes to a copy of it. Throws if the definition is
+    // shared.
+    template <typename F>
+    auto change_own_interface(F&& change);
+
+    // Takes ownership of (floating) `parameters`. Throws if there's no connection.
+    void emit_signal(const std::string& interface_name, const std::string& signal_name, const char* destination,
+                     GVariant* parameters) const;
+
+    void emit_properties_update_signal(const object_path_t& object_path, const std::string& interface_name,
+                                       const std::string& property_name, GVariant* value) const;
+
+    // Returns (a new reference to) the cached value of `property_name`, calling the getter on a cache miss.
+    GVariant* cached_property_value(const std::string& property_name, const property_read_handler_t& getter,
+                                    const dbus_context& context);
+
+    // True if `value` is what `property_name` already holds (only checked if skip_no_ops_ is set).
+    bool property_unchanged(const std::string& property_name, const property_read_handler_t& getter, GVariant* value,
+                            const dbus_context& context) const;
+
+    struct pending_property_changes;
+
+    // Sends a single PropertiesChanged signal for all of `values` (of `interface_name`), from `object_path`.
+    void emit_properties_changed(const object_path_t& object_path, const std::string& interface_name,
+                                 const std::map<std::string, g_variant_ptr>& values) const;
+
+    static gboolean on_property_changes_timeout(gpointer user_data);
+    static void     free_property_changes_ref(gpointer user_data);
+
+    struct pending_registration;
+
+    static gboolean on_registration_idle(gpointer user_data);
+    static void     free_registration_ref(gpointer user_data);
 
     static void handle_method_call(GDBusConnection* connection, const gchar* sender, const gchar* object_path,
                                    const gchar* interface_name, const gchar* method_name, GVariant* parameters,
@@ -197,22 +402,50 @@ private:
 
     static void g_thread_pool_function(gpointer data, gpointer user_data);
 
+    static gchar** subtree_enumerate(GDBusConnection* connection, const gchar* sender, const gchar* object_path,
+                                     gpointer user_data);
+
+    static GDBusInterfaceInfo** subtree_introspect(GDBusConnection* connection, const gchar* sender,
+                                                   const gchar* object_path, const gchar* node, gpointer user_data);
+
+    static const GDBusInterfaceVTable* subtree_dispatch(GDBusConnection* connection, const gchar* sender,
+                                                        const gchar* object_path, const gchar* interface_name,
+                                                        const gchar* node, gpointer* out_user_data,
+                                                        gpointer user_data);
+
 private:
-    session_manager&                                                                              session_manager_;
-    guint                                                                                         registration_id_ {0};
-    std::string                                                                                   interface_name_;
-    object_path_t                                                                                 object_path_;
-    std::string                                                                                   methods_xml_;
-    std::string                                                                                   properties_xml_;
-    std::string                                                                                   signals_xml_;
-    std::unordered_map<std::string, method_handler_t>                                             methods_;
-    std::unordered_map<std::string, std::pair<property_read_handler_t, property_write_handler_t>> properties_;
-    g_dbus_node_info_ptr                                                                          introspection_data_;
-    static g_thread_pool                                                                          thread_pool_;
-    pre_request_handler_t                                                                         pre_request_handler_;
-    static inline const GDBusInterfaceVTable                                                      interface_vtable_ {
+    session_manager&                                         session_manager_;
+    std::map<std::string, guint>                             registration_ids_;
+    object_path_t                                            object_path_;
+    std::shared_ptr<const interface_definition>              interface_;
+    const std::string                                        interface_name_;
+    std::shared_ptr<interface_definition>                    own_interface_;
+    std::mutex                                               own_interface_mutex_;
+    std::shared_ptr<const interface_definition>              registered_interface_;
+    std::shared_ptr<pending_registration>                    registration_;
+    std::vector<std::shared_ptr<const interface_definition>> extra_interfaces_;
+    mutable std::mutex                                       interfaces_mutex_;
+    void*                                                    state_ {nullptr};
+    static g_thread_pool                                     thread_pool_;
+    pre_request_handler_t                                    pre_request_handler_;
+    std::shared_ptr<pending_property_changes>                property_changes_;
+    std::atomic<bool>                                        skip_no_ops_ {false};
+    std::unordered_map<std::string, g_variant_ptr>           last_written_values_;
+    std::atomic<bool>                                        cache_values_ {false};
+    std::unordered_map<std::string, g_variant_ptr>           property_cache_;
+    mutable std::mutex                                       property_cache_mutex_;
+    std::vector<std::function<void()>>                       cell_detachers_;
+    mutable idle_state                                       idle_state_;
+    lookup_child_t                                           lookup_child_;
+    enumerate_children_t                                     enumerate_children_;
+    static inline const GDBusInterfaceVTable                 interface_vtable_ {
         handle_method_call, handle_get_property, handle_set_property, {}};
+    static inline const GDBusSubtreeVTable                   subtree_vtable_ {
+        subtree_enumerate, subtree_introspect, subtree_dispatch, {}};
 
+    friend class idle_detector;
+    friend class interface_definition;
+    friend class object_manager;
     friend class session_manager;
 };
 
@@ -0,0 +1,76 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#ifndef __OBJECT_MANAGER_H_INCLUDED__
+#define __OBJECT_MANAGER_H_INCLUDED__
+
+#include "object.h"
+#include "types.h"
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace easydbuspp {
+
+class session_manager;
+
+/*!
+ * An implementation of the `org.freedesktop.DBus.ObjectManager` interface, which lets clients load all the
+ * objects below a path, with all their interfaces and property values, in a single `GetManagedObjects`
+ * call, and then keep up to date by listening to its `InterfacesAdded` and `InterfacesRemoved` signals.
+ *
+ * It manages every object attached to its session_manager whose path is below its own (but not the
+ * object at its own path). Subtree objects contribute the children they can enumerate to
+ * `GetManagedObjects`, but their children coming and going isn't signalled.
+ */
+class object_manager {
+
+public:
+    static constexpr const char* INTERFACE_NAME = "org.freedesktop.DBus.ObjectManager";
+
+public:
+    /*!
+     * Constructor.
+     *
+     * @param session_mgr This object is responsible for establishing and maintaining the D-Bus connection.
+     * @param object_path The path the interface is served at, and the root of the managed objects' tree
+     *                    (e.g. "/net/my_domain/my_host").
+     */
+    object_manager(session_manager& session_mgr, const object_path_t& object_path);
+
+    //! Destructor.
+    ~object_manager();
+
+    object_manager(const object_manager&)            = delete;
+    object_manager& operator=(const object_manager&) = delete;
+
+    //! Returns the path the manager is served at.
+    object_path_t object_path() const;
+
+private:
+    // True if `object_path` is a strict descendant of the manager's path.
+    bool manages(const object_path_t& object_path) const;
+
+    // The return value of GetManagedObjects, as seen by `sender`.
+    std::map<object_path_t, interfaces_and_properties_t> managed_objects(const std::string& sender) const;
+
+    // Called by the session_manager, which holds its objects lock.
+    void interfaces_added(const object&                                                   obj,
+                          const std::vector<std::shared_ptr<const interface_definition>>& definitions);
+    void interfaces_removed(const object& obj, const std::vector<std::string>& interface_names);
+
+private:
+    session_manager&                                                session_manager_;
+    object                                                          object_;
+    std::function<void(object_path_t, interfaces_and_properties_t)> interfaces_added_;
+    std::function<void(object_path_t, std::vector<std::string>)>    interfaces_removed_;
+
+    friend class session_manager;
+};
+
+} // end of namespace easydbuspp
+
+#endif // __OBJECT_MANAGER_H_INCLUDED__
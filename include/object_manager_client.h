@@ -0,0 +1,121 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#ifndef __OBJECT_MANAGER_CLIENT_H_INCLUDED__
+#define __OBJECT_MANAGER_CLIENT_H_INCLUDED__
+
+#include "params.h"
+#include "types.h"
+#include <functional>
+#include <gio/gio.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace easydbuspp {
+
+class session_manager;
+
+/*!
+ * A local mirror of all the objects published by a remote `org.freedesktop.DBus.ObjectManager` (such
+ * as an easydbuspp::object_manager). It loads everything with a single `GetManagedObjects` call, and
+ * then keeps up to date by applying the `InterfacesAdded`, `InterfacesRemoved` and `PropertiesChanged`
+ * signals as they come in. Reading a property is a local lookup, with no bus traffic.
+ *
+ * Signals are handled by the thread running the main loop. All member functions are thread-safe.
+ */
+class object_manager_client {
+
+public:
+    //! Gets an object's path, and the names of the interfaces it gained (or lost).
+    using interfaces_handler_t = std::function<void(const object_path_t&, const std::vector<std::string>&)>;
+
+    //! Gets an object's path, an interface name, and the names of the properties of that interface that changed.
+    using properties_handler_t
+        = std::function<void(const object_path_t&, const std::string&, const std::vector<std::string>&)>;
+
+public:
+    /*!
+     * Constructor. Subscribes to the manager's signals, then loads all its objects.
+     *
+     * @param session_mgr The session_manager object that manages an established connection to the D-Bus.
+     * @param bus_name    The bus name of the remote service.
+     * @param object_path The path of the remote object manager.
+     * @throw             std::runtime_error
+     */
+    object_manager_client(session_manager& session_mgr, const std::string& bus_name, const object_path_t& object_path);
+
+    //! Destructor. Unsubscribes from the manager's signals.
+    ~object_manager_client();
+
+    object_manager_client(const object_manager_client&)            = delete;
+    object_manager_client& operator=(const object_manager_client&) = delete;
+
+    /*!
+     * Reload everything with a new `GetManagedObjects` call (e.g. after the remote service restarted).
+     * Signals received while the call is in progress are applied on top of its result.
+     *
+     * @throw std::runtime_error
+     */
+    void refresh();
+
+    //! Returns the paths of all the objects, or only of those implementing `interface_name`, if not empty.
+    std::vector<object_path_t> object_paths(const std::string& interface_name = {}) const;
+
+    //! Returns the names of the interfaces of an object (empty for unknown objects).
+    std::vector<std::string> interface_names(const object_path_t& object_path) const;
+
+    //! True if the object at `object_path` is known, and implements `interface_name`.
+    bool has_interface(const object_path_t& object_path, const std::string& interface_name) const;
+
+    /*!
+     * Returns the mirrored value of a property.
+     *
+     * @param object_path    The path of the object.
+     * @param interface_name The interface the property belongs to.
+     * @param property_name  The name of the property.
+     * @return               The property's value, converted to a `T`.
+     * @throw                std::runtime_error If the property isn't known. Properties a `PropertiesChanged`
+     *                       signal invalidates (rather than sending their new value) are forgotten.
+     */
+    template <typename T>
+    T property(const object_path_t& object_path, const std::string& interface_name,
+               const std::string& property_name) const;
+
+    //! Same as `property()`, but returns the value undecoded.
+    raw_variant raw_property(const object_path_t& object_path, const std::string& interface_name,
+                             const std::string& property_name) const;
+
+    //! (Optionally) set a function to be called after objects (or interfaces of objects) are added.
+    void interfaces_added_handler(const interfaces_handler_t& handler);
+
+    //! (Optionally) set a function to be called after objects (or interfaces of objects) are removed.
+    void interfaces_removed_handler(const interfaces_handler_t& handler);
+
+    //! (Optionally) set a function to be called after properties change.
+    void properties_changed_handler(const properties_handler_t& handler);
+
+private:
+    struct mirror;
+
+    static void on_signal(GDBusConnection* connection, const gchar* sender_name, const gchar* object_path,
+                          const gchar* interface_name, const gchar* signal_name, GVariant* parameters,
+                          gpointer user_data);
+
+    static void free_mirror_ref(gpointer user_data);
+
+private:
+    session_manager&        session_manager_;
+    std::string             bus_name_;
+    object_path_t           object_path_;
+    std::shared_ptr<mirror> mirror_;
+    guint                   manager_subscription_ {0};
+    guint                   properties_subscription_ {0};
+};
+
+} // end of namespace easydbuspp
+
+#include "object_manager_client.inl"
+
+#endif // __OBJECT_MANAGER_CLIENT_H_INCLUDED__
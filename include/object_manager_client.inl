@@ -0,0 +1,22 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#ifndef __OBJECT_MANAGER_CLIENT_INL_INCLUDED__
+#define __OBJECT_MANAGER_CLIENT_INL_INCLUDED__
+
+namespace easydbuspp {
+
+template <typename T>
+T object_manager_client::property(const object_path_t& object_path, const std::string& interface_name,
+                                  const std::string& property_name) const
+{
+    // The raw_variant holds on to the value, so it's decoded without holding any locks.
+    raw_variant value = raw_property(object_path, interface_name, property_name);
+
+    return from_gvariant<T>(value.get());
+}
+
+} // end of namespace easydbuspp
+
+#endif // __OBJECT_MANAGER_CLIENT_INL_INCLUDED__
@@ -5,17 +5,71 @@
 #ifndef __PARAMS_H_INCLUDED__
 #define __PARAMS_H_INCLUDED__
 
+#include "compressed_bytes.h"
+#include "request_arena.h"
+#include "shared_buffer.h"
+#include "stream.h"
 #include "type_mapping.h"
 #include "types.h"
+#include <algorithm>
+#include <array>
 #include <gio/gunixfdlist.h>
 #include <glib-unix.h>
 #include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
 
 namespace easydbuspp {
 
 template <typename... Types>
 void extract(GVariant* v, std::variant<Types...>& out);
 
+template <typename T>
+std::decay_t<T> from_gvariant(GVariant* v);
+
+// Empty container to decode into. std::pmr containers get the current request's arena.
+template <typename T>
+T make_container()
+{
+    if constexpr (is_pmr_container_v<T>)
+        return T(typename T::allocator_type {request_memory_resource()});
+    else
+        return T {};
+}
+
+inline g_variant_ptr struct_child(GVariant* v, size_t index)
+{
+    g_variant_ptr child_value {g_variant_get_child_value(v, index), g_variant_unref};
+
+    if (!child_value)
+        throw std::runtime_error {"nullptr child on GVariant -> struct conversion!"};
+
+    return child_value;
+}
+
+// Tuples and pairs are built straight from their decoded members, which (unlike assigning to a default
+// constructed tuple) keeps std::pmr members in the memory resource they were decoded into.
+template <typename T, size_t... I>
+T tuple_from_gvariant([[maybe_unused]] GVariant* v, std::index_sequence<I...>)
+{
+    return T {from_gvariant<std::tuple_element_t<I, T>>(struct_child(v, I).get())...};
+}
+
+// EASYDBUSPP_STRUCT() types: each decoded member is moved into place through its member pointer.
+template <typename T, size_t... I>
+T dbus_struct_from_gvariant(GVariant* v, std::index_sequence<I...>)
+{
+    constexpr auto members = easydbuspp_struct_members(static_cast<const T*>(nullptr));
+    T              ret {};
+
+    ((ret.*std::get<I>(members) = from_gvariant<std::tuple_element_t<I, dbus_struct_tuple_t<T>>>(
+          struct_child(v, I).get())),
+     ...);
+
+    return ret;
+}
+
 template <typename T>
 std::decay_t<T> from_gvariant(GVariant* v)
 {
@@ -41,31 +95,32 @@ std::decay_t<T> from_gvariant(GVariant* v)
         return std::byte {g_variant_get_byte(v)};
     else if constexpr (decay_same_v<T, unix_fd_t>)
         return unix_fd_t {g_variant_get_handle(v)};
-    else if constexpr (decay_same_v<T, std::string> || decay_same_v<T, object_path_t>)
-        return g_variant_get_string(v, nullptr);
-    else if constexpr (is_tuple_like_v<T>) {
+    else if constexpr (decay_same_v<T, shared_buffer>)
+        return shared_buffer::decode(v);
+    else if constexpr (is_fd_backed_v<T>) {
+        // Only the fd index for now, set_up_from_g_unix_fd_list() takes over the actual fd.
         std::decay_t<T> ret;
-        int             index = 0;
-
-        auto extract_current_item = [v, &index](auto& arg) {
-            g_variant_ptr child_value {g_variant_get_child_value(v, index++), g_variant_unref};
-
-            if (!child_value)
-                throw std::runtime_error {"nullptr child on GVariant -> std::tuple conversion!"};
-
-            arg = from_gvariant<decltype(arg)>(child_value.get());
-        };
-
-        std::apply(
-            [&extract_current_item](auto&&... args) {
-                ((extract_current_item(args)), ...);
-            },
-            ret);
-
+        ret.fd_index_ = g_variant_get_handle(v);
         return ret;
-    } else if constexpr (is_vector_v<T>) {
+    } else if constexpr (decay_same_v<T, std::string> || decay_same_v<T, object_path_t>)
+        return g_variant_get_string(v, nullptr);
+    else if constexpr (decay_same_v<T, std::pmr::string>)
+        return std::pmr::string(g_variant_get_string(v, nullptr), request_memory_resource());
+    else if constexpr (decay_same_v<T, raw_variant>)
+        return raw_variant {g_variant_get_variant(v)};
+    else if constexpr (decay_same_v<T, compressed_bytes>)
+        return compressed_bytes::decode(v);
+    else if constexpr (is_lazy_v<T>)
+        return std::decay_t<T> {g_variant_ref(v)};
+    else if constexpr (is_tuple_like_v<T>)
+        return tuple_from_gvariant<std::decay_t<T>>(v,
+                                                    std::make_index_sequence<std::tuple_size_v<std::decay_t<T>>> {});
+    else if constexpr (is_dbus_struct_v<T>)
+        return dbus_struct_from_gvariant<std::decay_t<T>>(
+            v, std::make_index_sequence<std::tuple_size_v<dbus_struct_tuple_t<T>>> {});
+    else if constexpr (is_vector_v<T>) {
         const std::string type {"a" + to_dbus_type_string<typename std::decay_t<T>::value_type>()};
-        std::decay_t<T>   ret;
+        auto              ret = make_container<std::decay_t<T>>();
 
         GVariantIter* list {nullptr};
         g_variant_get(v, type.c_str(), &list);
@@ -87,7 +142,7 @@ std::decay_t<T> from_gvariant(GVariant* v)
         const std::string type {"a{" + to_dbus_type_string<decayed_key_type>()
                                 + to_dbus_type_string<decayed_mapped_type>() + "}"};
 
-        std::decay_t<T> ret;
+        auto ret = make_container<std::decay_t<T>>();
 
         GVariantIter* list {nullptr};
         g_variant_get(v, type.c_str(), &list);
@@ -111,15 +166,47 @@ std::decay_t<T> from_gvariant(GVariant* v)
         throw std::runtime_error {"Don't know how to extract "s + typeid(T).name() + " from a GVariant!"};
 }
 
+template <typename V, size_t... I>
+const auto& variant_extractors(std::index_sequence<I...>)
+{
+    using entry_t = std::pair<std::string, void (*)(GVariant*, V&)>;
+
+    // Built once per std::variant<> type: each alternative's D-Bus signature, next to a function that
+    // decodes a GVariant into that alternative. Sorted by signature, so that extract() can binary search
+    // it with the type string GLib hands out, without building an std::string first. If several
+    // alternatives share a signature (e.g. double and float), the first one wins: the sort is stable.
+    static const std::array<entry_t, sizeof...(I)> extractors = [] {
+        std::array<entry_t, sizeof...(I)> entries {
+            entry_t {to_dbus_type_string<std::variant_alternative_t<I, V>>(), [](GVariant* v, V& out) {
+                          out.template emplace<I>(from_gvariant<std::variant_alternative_t<I, V>>(v));
+                      }}...};
+
+        std::stable_sort(entries.begin(), entries.end(), [](const entry_t& a, const entry_t& b) {
+            return a.first < b.first;
+        });
+
+        return entries;
+    }();
+
+    return extractors;
+}
+
 template <typename... Types>
 void extract(GVariant* v, std::variant<Types...>& out)
 {
-    (
-        [&] {
-            if (g_variant_is_of_type(v, to_dbus_type<Types>()))
-                out = from_gvariant<Types>(v);
-        }(),
-        ...);
+    using namespace std::string_literals;
+
+    const auto&      extractors = variant_extractors<std::variant<Types...>>(std::index_sequence_for<Types...> {});
+    std::string_view type {g_variant_get_type_string(v)};
+
+    auto it = std::lower_bound(extractors.begin(), extractors.end(), type, [](const auto& entry, std::string_view t) {
+        return std::string_view {entry.first} < t;
+    });
+
+    if (it == extractors.end() || it->first != type)
+        throw std::runtime_error {"No std::variant alternative matches D-Bus type '"s + std::string {type} + "'!"};
+
+    it->second(v, out);
 }
 
 template <typename T>
@@ -134,21 +221,43 @@ std::decay_t<T> extract(GVariant* parameters, gsize index)
 }
 
 template <typename T>
-GVariant* to_gvariant(T t)
+GVariant* to_gvariant(const T& t)
 {
     using namespace std::string_literals;
 
-    if constexpr (std::is_arithmetic_v<T> || decay_same_v<T, const char*>)
-        return g_variant_new(to_dbus_type_string(t).c_str(), t);
+    // String literals bind here as const char[N], which only decays to const char* when const-qualified.
+    if constexpr (std::is_arithmetic_v<T> || decay_same_v<const T, const char*>)
+        return g_variant_new(to_dbus_type_string<const T>().c_str(), t);
     else if constexpr (decay_same_v<T, std::byte>)
-        return g_variant_new(to_dbus_type_string(t).c_str(), std::to_integer<uint8_t>(t));
+        return g_variant_new(to_dbus_type_string<T>().c_str(), std::to_integer<uint8_t>(t));
     else if constexpr (decay_same_v<T, unix_fd_t>)
-        return g_variant_new(to_dbus_type_string(t).c_str(), static_cast<gint32>(t));
-    else if constexpr (decay_same_v<T, std::string>)
-        return g_variant_new(to_dbus_type_string(t).c_str(), t.c_str());
+        return g_variant_new(to_dbus_type_string<T>().c_str(), static_cast<gint32>(t));
+    else if constexpr (decay_same_v<T, shared_buffer>)
+        return t.encode();
+    else if constexpr (is_fd_backed_v<T>) {
+        if (t.fd_index_ < 0)
+            throw std::runtime_error {typeid(T).name() + " can only be sent as a method parameter or return value!"s};
+
+        return g_variant_new_handle(t.fd_index_);
+    } else if constexpr (decay_same_v<T, std::string> || decay_same_v<T, std::pmr::string>)
+        return g_variant_new(to_dbus_type_string<T>().c_str(), t.c_str());
     else if constexpr (decay_same_v<T, object_path_t>)
-        return g_variant_new(to_dbus_type_string(t).c_str(), t.generic_string().c_str());
-    else if constexpr (is_tuple_like_v<T>) {
+        return g_variant_new(to_dbus_type_string<T>().c_str(), t.generic_string().c_str());
+    else if constexpr (decay_same_v<T, raw_variant>) {
+        if (!t)
+            throw std::runtime_error {"Can't send an empty raw_variant!"};
+
+        return g_variant_new_variant(t.get());
+    } else if constexpr (decay_same_v<T, compressed_bytes>)
+        return t.encode();
+    else if constexpr (is_lazy_v<T>) {
+        if (!t.gvariant())
+            throw std::runtime_error {"Can't send an empty lazy<T>!"};
+
+        // Share the serialized data we were given instead of decoding and re-encoding it.
+        g_bytes_ptr data {g_variant_get_data_as_bytes(t.gvariant()), g_bytes_unref};
+        return g_variant_new_from_bytes(g_variant_get_type(t.gvariant()), data.get(), TRUE);
+    } else if constexpr (is_tuple_like_v<T>) {
         g_variant_builder_ptr builder {g_variant_builder_new(G_VARIANT_TYPE_TUPLE), g_variant_builder_unref};
 
         std::apply(
@@ -158,17 +267,22 @@ GVariant* to_gvariant(T t)
             t);
 
         return g_variant_builder_end(builder.get());
+    } else if constexpr (is_dbus_struct_v<T>) {
+        // Members are serialized in place, straight into the struct GVariant.
+        return std::apply(
+            [&t](auto... members) {
+                GVariant* children[] = {to_gvariant(t.*members)...};
+                return g_variant_new_tuple(children, sizeof...(members));
+            },
+            easydbuspp_struct_members(&t));
     } else if constexpr (is_map_like_v<T>) {
-        const std::string type {"a{" + to_dbus_type_string<typename T::key_type>()
-                                + to_dbus_type_string<typename T::mapped_type>() + "}"};
-        const std::string elem_type {"{@" + to_dbus_type_string<typename T::key_type>() + "@"
-                                     + to_dbus_type_string<typename T::mapped_type>() + "}"};
+        // Computed once per map type; entries are then built directly, without parsing a format string.
+        static const std::string type {to_dbus_type_string<T>()};
 
         g_variant_builder_ptr builder {g_variant_builder_new(G_VARIANT_TYPE(type.c_str())), g_variant_builder_unref};
 
         for (auto&& [key, value] : t)
-            g_variant_builder_add_value(builder.get(),
-                                        g_variant_new(elem_type.c_str(), to_gvariant(key), to_gvariant(value)));
+            g_variant_builder_add_value(builder.get(), g_variant_new_dict_entry(to_gvariant(key), to_gvariant(value)));
 
         return g_variant_builder_end(builder.get());
     } else if constexpr (is_variant_v<T>) {
@@ -182,8 +296,9 @@ GVariant* to_gvariant(T t)
 
         return g_variant_builder_end(builder.get());
     } else if constexpr (is_vector_v<T>) {
-        g_variant_builder_ptr builder {g_variant_builder_new(G_VARIANT_TYPE(to_dbus_type_string<T>().c_str())),
-                                       g_variant_builder_unref};
+        static const std::string type {to_dbus_type_string<T>()};
+
+        g_variant_builder_ptr builder {g_variant_builder_new(G_VARIANT_TYPE(type.c_str())), g_variant_builder_unref};
 
         for (auto&& elem : t)
             g_variant_builder_add_value(builder.get(), to_gvariant(elem));
@@ -199,23 +314,32 @@ GUnixFDList* extract_g_unix_fd_list(std::tuple<A...>& input)
     g_unix_fd_list_ptr fd_list {nullptr, g_object_unref};
     gint32             fd_list_index {0};
 
-    auto extract_arg = [&](auto& arg) {
-        if constexpr (std::is_same_v<std::decay_t<decltype(arg)>, unix_fd_t>) {
-            if (!fd_list)
-                fd_list.reset(g_unix_fd_list_new());
+    auto append_fd = [&](gint32 fd) {
+        if (!fd_list)
+            fd_list.reset(g_unix_fd_list_new());
 
-            GError* error {nullptr};
+        GError* error {nullptr};
 
-            g_unix_fd_list_append(fd_list.get(), static_cast<gint32>(arg), &error);
-            arg = unix_fd_t {fd_list_index++};
+        g_unix_fd_list_append(fd_list.get(), fd, &error);
 
-            if (error) {
-                std::string error_message = error->message;
-                g_error_free(error);
+        if (error) {
+            std::string error_message = error->message;
+            g_error_free(error);
 
-                throw std::runtime_error("Could not add UNIX fd: " + error_message);
-            }
+            throw std::runtime_error("Could not add UNIX fd: " + error_message);
         }
+
+        return fd_list_index++;
+    };
+
+    auto extract_arg = [&](auto& arg) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(arg)>, unix_fd_t>)
+            arg = unix_fd_t {append_fd(static_cast<gint32>(arg))};
+        else if constexpr (std::is_same_v<std::decay_t<decltype(arg)>, shared_buffer>) {
+            if (!arg.inline_bytes())
+                arg.fd_index_ = append_fd(arg.fd());
+        } else if constexpr (is_fd_backed_v<decltype(arg)>)
+            arg.fd_index_ = append_fd(arg.fd());
     };
 
     std::apply(
@@ -230,21 +354,31 @@ GUnixFDList* extract_g_unix_fd_list(std::tuple<A...>& input)
 template <typename... A>
 void set_up_from_g_unix_fd_list(GUnixFDList* fd_list, std::tuple<A...>& inout)
 {
-    auto set_up = [&](auto& arg) {
-        if constexpr (std::is_same_v<std::decay_t<decltype(arg)>, unix_fd_t>) {
-            if (!fd_list)
-                throw std::runtime_error("UNIX fd parameter encountered but no fd list received!");
+    auto get_fd = [&](gint32 index) {
+        if (!fd_list)
+            throw std::runtime_error("UNIX fd parameter encountered but no fd list received!");
 
-            GError* error {nullptr};
-            arg = unix_fd_t {g_unix_fd_list_get(fd_list, static_cast<gint32>(arg), &error)};
+        GError* error {nullptr};
+        gint32  fd = g_unix_fd_list_get(fd_list, index, &error);
 
-            if (error) {
-                std::string error_message = error->message;
-                g_error_free(error);
+        if (error) {
+            std::string error_message = error->message;
+            g_error_free(error);
 
-                throw std::runtime_error("Could not extract UNIX fd: " + error_message);
-            }
+            throw std::runtime_error("Could not extract UNIX fd: " + error_message);
         }
+
+        return fd;
+    };
+
+    auto set_up = [&](auto& arg) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(arg)>, unix_fd_t>)
+            arg = unix_fd_t {get_fd(static_cast<gint32>(arg))};
+        else if constexpr (std::is_same_v<std::decay_t<decltype(arg)>, shared_buffer>) {
+            if (arg.fd_index_ >= 0)
+                arg = shared_buffer::adopt(get_fd(arg.fd_index_));
+        } else if constexpr (is_fd_backed_v<decltype(arg)>)
+            arg = std::decay_t<decltype(arg)>::adopt(get_fd(arg.fd_index_));
     };
 
     std::apply(
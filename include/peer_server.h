@@ -0,0 +1,87 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#ifndef __PEER_SERVER_H_INCLUDED__
+#define __PEER_SERVER_H_INCLUDED__
+
+#include "session_manager.h"
+#include "types.h"
+#include <functional>
+#include <gio/gio.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace easydbuspp {
+
+/*!
+ * Serves objects over direct (peer-to-peer) D-Bus connections, with no bus daemon relaying the messages.
+ * The wire format is the same, but each message is copied (and context switched) half as many times.
+ *
+ * Every peer that connects gets a session_manager of its own, and the peer handler creates the objects
+ * that peer should see on it. Only peers running as the same user as the server are let in. New peers
+ * (and peers going away) are handled on the thread running the main_loop.
+ */
+class peer_server {
+
+public:
+    /*!
+     * Gets the session_manager of a peer that has just connected, and creates the objects that peer
+     * should see. Returns whatever has to be kept alive while the peer is connected (usually, those
+     * objects). The objects are destroyed (and then the session_manager) when the peer goes away.
+     */
+    using peer_handler_t = std::function<std::shared_ptr<void>(session_manager&)>;
+
+public:
+    /*!
+     * Constructor. Starts listening right away.
+     *
+     * @param address      Where to listen, as a D-Bus address (e.g. "unix:path=/run/my_service/socket", or
+     *                     "unix:tmpdir=/tmp" for a randomly named socket).
+     * @param peer_handler Called for each new peer.
+     * @param dispatch     (Optional) Which thread dispatches the peers' D-Bus events.
+     * @throw              std::runtime_error
+     */
+    peer_server(const std::string& address, const peer_handler_t& peer_handler,
+                dispatch_t dispatch = dispatch_t::MAIN_LOOP);
+
+    //! Destructor. Stops listening, and disconnects all peers.
+    ~peer_server();
+
+    peer_server(const peer_server&)            = delete;
+    peer_server& operator=(const peer_server&) = delete;
+
+    //! Returns the address clients should connect to (see `session_manager(const peer_address_t&)`).
+    peer_address_t client_address() const;
+
+    //! Returns the number of peers currently connected.
+    size_t peer_count() const;
+
+private:
+    struct peer {
+        std::unique_ptr<session_manager> session;
+        std::shared_ptr<void>            state;
+        gulong                           closed_handler_id {0};
+    };
+
+    static gboolean on_new_connection(GDBusServer* server, GDBusConnection* connection, gpointer user_data);
+    static void     on_connection_closed(GDBusConnection* connection, gboolean remote_peer_vanished, GError* error,
+                                         gpointer user_data);
+
+    // The peer's objects go first, then its session_manager.
+    static void disconnect(GDBusConnection* connection, peer& p);
+
+private:
+    GDBusServer*                     server_ {nullptr};
+    gulong                           new_connection_handler_id_ {0};
+    peer_handler_t                   peer_handler_;
+    dispatch_t                       dispatch_;
+    mutable std::mutex               peers_mutex_;
+    std::map<GDBusConnection*, peer> peers_;
+};
+
+} // end of namespace easydbuspp
+
+#endif // __PEER_SERVER_H_INCLUDED__
@@ -0,0 +1,86 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#ifndef __PROPERTY_CELL_H_INCLUDED__
+#define __PROPERTY_CELL_H_INCLUDED__
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+
+namespace easydbuspp {
+
+class object;
+
+// Only instantiated for trivially copyable types (std::atomic<T> requires them).
+template <typename T>
+struct is_always_lock_free_atomic : std::bool_constant<std::atomic<T>::is_always_lock_free> { };
+
+/*!
+ * A property value that can be safely shared between the D-Bus thread and application threads. Pass one
+ * to `object::add_property()` instead of a plain variable to get a readwrite property whose value can be
+ * read and updated from any thread.
+ *
+ * Small trivially copyable types (integers, doubles, bools) are kept in a lock-free `std::atomic<T>`.
+ * Anything else is kept as an immutable snapshot: `store()` builds a new `std::shared_ptr<const T>` and
+ * then swaps it in, and readers keep using the snapshot they got for as long as they need it. Readers
+ * never wait for a writer to build (copy, allocate) a new value, but the pointer swap itself isn't
+ * lock-free: `std::atomic_load()` / `std::atomic_store()` on a `std::shared_ptr` take a lock (libstdc++
+ * uses a global pool of mutexes) for as long as it takes to copy the pointer.
+ */
+template <typename T>
+class property_cell {
+
+public:
+    using value_type = T;
+
+    //! True if the value is kept in an `std::atomic<T>`, rather than as a shared snapshot.
+    static constexpr bool is_atomic = std::conjunction_v<std::is_trivially_copyable<T>, is_always_lock_free_atomic<T>>;
+
+    property_cell() : property_cell(T {}) { }
+    explicit property_cell(T value);
+
+    property_cell(const property_cell&)            = delete;
+    property_cell& operator=(const property_cell&) = delete;
+
+    //! Returns a copy of the current value.
+    T load() const;
+
+    /*!
+     * Replaces the current value. If the cell has been added to an object as a property, this also
+     * lets the object know (which will drop any cached value and, if requested when adding the
+     * property, emit a `PropertiesChanged` signal).
+     */
+    void store(T value);
+
+    //! Calls `reader` with a (const) reference to a consistent current value, without copying it.
+    template <typename F>
+    decltype(auto) read(F&& reader) const;
+
+private:
+    void store_quietly(T value);
+
+    // Sets the hook store() calls. A cell can only back one property at a time.
+    void attach(std::function<void()> on_store);
+
+    // Clears the hook, waiting for any store() that is still running it to finish.
+    void detach();
+
+private:
+    using storage_t = std::conditional_t<is_atomic, std::atomic<T>, std::shared_ptr<const T>>;
+
+    storage_t             value_;
+    std::mutex            on_store_mutex_;
+    std::function<void()> on_store_;
+
+    friend class object;
+};
+
+} // end of namespace easydbuspp
+
+#include "property_cell.inl"
+
+#endif // __PROPERTY_CELL_H_INCLUDED__
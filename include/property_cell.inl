@@ -0,0 +1,85 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#ifndef __PROPERTY_CELL_INL_INCLUDED__
+#define __PROPERTY_CELL_INL_INCLUDED__
+
+#include <stdexcept>
+#include <utility>
+
+namespace easydbuspp {
+
+template <typename T>
+property_cell<T>::property_cell(T value)
+{
+    store_quietly(std::move(value));
+}
+
+template <typename T>
+T property_cell<T>::load() const
+{
+    if constexpr (is_atomic)
+        return value_.load(std::memory_order_acquire);
+    else
+        return *std::atomic_load_explicit(&value_, std::memory_order_acquire);
+}
+
+template <typename T>
+void property_cell<T>::store(T value)
+{
+    store_quietly(std::move(value));
+
+    // Held while the hook runs, so that the object can't go away in the middle of it.
+    std::lock_guard lock {on_store_mutex_};
+
+    if (on_store_)
+        on_store_();
+}
+
+template <typename T>
+template <typename F>
+decltype(auto) property_cell<T>::read(F&& reader) const
+{
+    if constexpr (is_atomic) {
+        const T value = value_.load(std::memory_order_acquire);
+        return std::forward<F>(reader)(value);
+    } else {
+        // Holding on to the snapshot keeps it alive even if a new value is stored in the meantime.
+        std::shared_ptr<const T> snapshot = std::atomic_load_explicit(&value_, std::memory_order_acquire);
+        return std::forward<F>(reader)(*snapshot);
+    }
+}
+
+template <typename T>
+void property_cell<T>::store_quietly(T value)
+{
+    if constexpr (is_atomic)
+        value_.store(value, std::memory_order_release);
+    else
+        std::atomic_store_explicit(&value_, std::shared_ptr<const T> {std::make_shared<T>(std::move(value))},
+                                   std::memory_order_release);
+}
+
+template <typename T>
+void property_cell<T>::attach(std::function<void()> on_store)
+{
+    std::lock_guard lock {on_store_mutex_};
+
+    if (on_store_)
+        throw std::runtime_error("This property_cell already backs another property!");
+
+    on_store_ = std::move(on_store);
+}
+
+template <typename T>
+void property_cell<T>::detach()
+{
+    std::lock_guard lock {on_store_mutex_};
+
+    on_store_ = {};
+}
+
+} // end of namespace easydbuspp
+
+#endif // __PROPERTY_CELL_INL_INCLUDED__
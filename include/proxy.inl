@@ -8,11 +8,11 @@
 namespace easydbuspp {
 
 template <typename R, typename... A>
-R proxy::call(const std::string& method_name, A... parameters) const
+R proxy::call(const std::string& method_name, A&&... parameters) const
 {
-    std::tuple<std::decay_t<A>...> fn_args {parameters...};
-    GError*                        error {nullptr};
-    GUnixFDList*                   out_fd_list {nullptr};
+    std::tuple<marshalled_arg_t<A>...> fn_args {parameters...};
+    GError*                            error {nullptr};
+    GUnixFDList*                       out_fd_list {nullptr};
 
     g_unix_fd_list_ptr fd_list {extract_g_unix_fd_list(fn_args), g_object_unref};
 
@@ -38,7 +38,7 @@ R proxy::call(const std::string& method_name, A... parameters) const
         } else {
             auto ret = from_gvariant<std::tuple<R>>(result.get());
             set_up_from_g_unix_fd_list(out_fd_list, ret);
-            return std::get<0>(ret);
+            return std::get<0>(std::move(ret));
         }
     }
 }
@@ -0,0 +1,39 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#ifndef __REQUEST_ARENA_H_INCLUDED__
+#define __REQUEST_ARENA_H_INCLUDED__
+
+#include <memory_resource>
+
+namespace easydbuspp {
+
+/*!
+ * The memory resource that `std::pmr` method parameters are decoded into. While a method call is being
+ * handled, this is a per-thread monotonic arena that gets recycled as soon as the call is done, so
+ * decoding is mostly bump-pointer allocation with nothing to free. Anywhere else, it is
+ * `std::pmr::get_default_resource()`.
+ *
+ * Use it to build `std::pmr` return values in the same arena. Anything allocated from it during a
+ * method call must not outlive that call.
+ */
+std::pmr::memory_resource* request_memory_resource();
+
+/*!
+ * Makes request_memory_resource() return the calling thread's arena for as long as it is alive. The
+ * arena is released when the outermost scope on the thread ends.
+ */
+class request_arena_scope {
+
+public:
+    request_arena_scope();
+    ~request_arena_scope();
+
+    request_arena_scope(const request_arena_scope&)            = delete;
+    request_arena_scope& operator=(const request_arena_scope&) = delete;
+};
+
+} // end of namespace easydbuspp
+
+#endif // __REQUEST_ARENA_H_INCLUDED__
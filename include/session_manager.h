@@ -5,17 +5,26 @@
 #ifndef __SESSION_MANAGER_H_INCLUDED__
 #define __SESSION_MANAGER_H_INCLUDED__
 
+#include "signal_subscription.h"
+#include "signal_table.h"
 #include "types.h"
+#include <condition_variable>
 #include <functional>
 #include <gio/gio.h>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 namespace easydbuspp {
 
+class interface_definition;
 class object;
+class object_manager;
 class proxy;
 
 /*!
@@ -24,26 +33,48 @@ class proxy;
  */
 class session_manager {
 
-    using signal_handler_t = std::function<void(GVariant*)>;
+    using signal_handler_t = signal_table::handler_t;
 
 public:
     /*!
      * Constructor. This synchronously connects to the D-Bus, but does not request a bus name.
      * It's the constructor to use when you only need to create proxies.
      *
-     * @param bus_type Which bus to connect to (the session or system bus).
+     * @param bus_type   Which bus to connect to (the session or system bus).
+     * @param dispatch   (Optional) Which thread dispatches signals (and proxy property updates).
+     * @param connection (Optional) Whether to use the process-wide connection to the bus, or open a new one.
      */
-    explicit session_manager(bus_type_t bus_type);
+    explicit session_manager(bus_type_t bus_type, dispatch_t dispatch = dispatch_t::MAIN_LOOP,
+                             connection_t connection = connection_t::SHARED);
 
     /*!
      * Constructor. This connects to the D-Bus to request a bus name.
      * It's the constructor to use when you want to use objects (to provide a service).
      * You may use proxies with it as well.
      *
-     * @param bus_type Which bus to connect to (the session or system bus).
-     * @param bus_name The requested bus name.
+     * @param bus_type   Which bus to connect to (the session or system bus).
+     * @param bus_name   The requested bus name.
+     * @param dispatch   (Optional) Which thread dispatches D-Bus events. With `dispatch_t::OWN_THREAD`, the
+     *                   session_manager runs its own thread and GMainContext, so its latency doesn't depend
+     *                   on whatever else is attached to the default context, and it doesn't need the main_loop
+     *                   to be running at all.
+     * @param connection (Optional) Whether to use the process-wide connection to the bus, or open a new one.
+     *                   With `connection_t::PRIVATE`, the connection is opened (synchronously) right away, so
+     *                   objects get registered as soon as they're created.
      */
-    session_manager(bus_type_t bus_type, const std::string& bus_name);
+    session_manager(bus_type_t bus_type, const std::string& bus_name, dispatch_t dispatch = dispatch_t::MAIN_LOOP,
+                    connection_t connection = connection_t::SHARED);
+
+    /*!
+     * Constructor. Connects directly to a peer_server, with no bus (and no bus daemon) in between.
+     * Proxies work as usual, except that their bus name is ignored (there's only one peer to talk to),
+     * and signal subscriptions can't filter by sender.
+     *
+     * @param peer     The address of the peer_server (see `peer_server::client_address()`).
+     * @param dispatch (Optional) Which thread dispatches signals (and proxy property updates).
+     * @throw          std::runtime_error
+     */
+    explicit session_manager(const peer_address_t& peer, dispatch_t dispatch = dispatch_t::MAIN_LOOP);
 
     //! Destructor. Detaches attached objects, releases the bus name.
     ~session_manager();
@@ -51,6 +82,14 @@ public:
     session_manager(const session_manager&)            = delete;
     session_manager& operator=(const session_manager&) = delete;
 
+    /*!
+     * Returns the unique bus name (e.g. ":1.42") of the session_manager's connection. Peer-to-peer
+     * connections don't have one, so it's empty for those.
+     *
+     * @throw std::runtime_error If there's no connection yet.
+     */
+    std::string unique_bus_name() const;
+
     /*!
      * Register a callback to be called when a signal is received.
      *
@@ -65,17 +104,63 @@ public:
      *                       Again, this will be missing for broadcast signals.
      * @param object_path    (Optional) The path of the object that is emitting the signal. Leave empty
      *                       when expecting broadcast signals.
+     * @param delivery       (Optional) Which thread the callback runs on. By default, it runs on the
+     *                       thread dispatching D-Bus events, which can't process anything else (method
+     *                       calls included) until it returns. Slow callbacks should use one of the other
+     *                       `signal_delivery_t` modes.
+     * @return               A handle that unsubscribes the callback when it goes away. Any number of
+     *                       callbacks may be subscribed to the same signal, with the same or different
+     *                       sender / interface / path filters.
+     * @throw                std::runtime_error
      */
     template <typename C>
-    void signal_subscribe(const std::string& signal_name, C&& callable, const std::string& sender = {},
-                          const std::string& interface_name = {}, const object_path_t& object_path = {});
+    [[nodiscard]] signal_subscription signal_subscribe(const std::string& signal_name, C&& callable,
+                                                       const std::string& sender = {},
+                                                       const std::string& interface_name = {},
+                                                       const object_path_t& object_path = {},
+                                                       const signal_delivery& delivery = {});
 
 private:
+    // Takes over a connection a peer_server has accepted.
+    session_manager(GDBusConnection* connection, dispatch_t dispatch);
+
+    // Objects attached while the connection is up get registered from the dispatch context, soon after.
     void attach(object* object_ptr);
     void detach(object* object_ptr);
 
+    void attach(object_manager* manager_ptr);
+    void detach(object_manager* manager_ptr);
+
+    // Let the object managers above `obj` know that it started (or stopped) serving some interfaces.
+    void interfaces_added(const object&                                                   obj,
+                          const std::vector<std::shared_ptr<const interface_definition>>& definitions);
+    void interfaces_removed(const object& obj, const std::vector<std::string>& interface_names);
+
+    // Calls `fn` for each of `candidates` that is still in `attached` (objects_ or object_managers_), without
+    // holding objects_mutex_, so that `fn` may run user code that creates or destroys objects. Whatever `fn` is
+    // called for can't be detached until it returns.
+    template <typename T, typename F>
+    void for_each_attached(const std::vector<T*>& candidates, const std::unordered_set<T*>& attached, F&& fn);
+
+    // Called with objects_mutex_ held: waits until for_each_attached() is done with `ptr`.
+    void wait_until_unused(std::unique_lock<std::mutex>& lock, const void* ptr);
+
     void setup_main_loop();
 
+    static GDBusConnection* open_connection(bus_type_t bus_type, connection_t connection);
+    static GDBusConnection* open_connection(const std::string& address, GDBusConnectionFlags flags);
+
+    void start_dispatch_thread();
+    void stop_dispatch_thread();
+
+    // GDBus dispatches callbacks on the GMainContext that was the thread-default one when they were registered.
+    // Runs `fn` on the dispatch thread (which owns the private context, if any), and waits for it to return.
+    template <typename F>
+    std::invoke_result_t<F> run_in_context(F&& fn);
+
+    static gboolean run_task(gpointer data);
+    static void     free_task(gpointer data);
+
     template <typename C, typename... A>
     signal_handler_t generate_signal_handler(C&& callable, const std::function<void(A...)>&);
 
@@ -83,21 +168,28 @@ private:
     static void on_name_acquired(GDBusConnection* connection, const gchar* name, gpointer user_data);
     static void on_name_lost(GDBusConnection* connection, const gchar* name, gpointer user_data);
 
-    static void on_signal(GDBusConnection* connection, const gchar* sender_name, const gchar* object_path,
-                          const gchar* interface_name, const gchar* signal_name, GVariant* parameters,
-                          gpointer user_data);
-
     static int stop_sighandler(void* param);
 
 private:
-    guint                                             owner_id_ {0};
-    GMainLoop*                                        loop_ {nullptr};
-    std::string                                       bus_name_;
-    std::unordered_set<object*>                       objects_;
-    std::unordered_map<std::string, signal_handler_t> signal_handlers_;
-    GDBusConnection*                                  connection_ {nullptr};
+    guint                                   owner_id_ {0};
+    GMainLoop*                              loop_ {nullptr};
+    std::string                             bus_name_;
+    std::unordered_set<object*>             objects_;
+    std::unordered_set<object_manager*>     object_managers_;
+    std::mutex                              objects_mutex_;
+    std::unordered_map<const void*, size_t> in_use_;
+    std::condition_variable                 in_use_cv_;
+    std::shared_ptr<signal_table>           signal_table_ {std::make_shared<signal_table>()};
+    GDBusConnection*                        connection_ {nullptr};
+    bool                                    private_connection_ {false};
+    GMainContext*                           context_ {nullptr};
+    GMainLoop*                              context_loop_ {nullptr};
+    std::thread                             dispatch_thread_;
 
     friend class object;
+    friend class object_manager;
+    friend class object_manager_client;
+    friend class peer_server;
     friend class proxy;
 };
 
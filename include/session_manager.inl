@@ -6,6 +6,7 @@
 #define __SESSION_MANAGER_INL_INCLUDED__
 
 #include "params.h"
+#include <future>
 
 namespace easydbuspp {
 
@@ -13,7 +14,7 @@ template <typename C, typename... A>
 session_manager::signal_handler_t session_manager::generate_signal_handler(C&& callable,
                                                                            const std::function<void(A...)>&)
 {
-    return [callable](GVariant* parameters) {
+    return [callable = std::forward<C>(callable)](GVariant* parameters) {
         std::tuple<std::decay_t<A>...> fn_args;
         gsize                          arg_index {0};
 
@@ -24,22 +25,83 @@ session_manager::signal_handler_t session_manager::generate_signal_handler(C&& c
             },
             fn_args);
 
-        std::apply(callable, fn_args);
+        std::apply(
+            [&callable](auto&... args) {
+                callable(std::forward<A>(args)...);
+            },
+            fn_args);
     };
 }
 
+template <typename T, typename F>
+void session_manager::for_each_attached(const std::vector<T*>& candidates, const std::unordered_set<T*>& attached,
+                                        F&& fn)
+{
+    for (T* ptr : candidates) {
+        {
+            std::lock_guard lock {objects_mutex_};
+
+            // Detached since the candidates were collected.
+            if (attached.count(ptr) == 0)
+                continue;
+
+            ++in_use_[ptr];
+        }
+
+        struct release_guard {
+            session_manager& manager;
+            const void*      ptr;
+
+            ~release_guard()
+            {
+                std::lock_guard lock {manager.objects_mutex_};
+
+                if (--manager.in_use_[ptr] == 0) {
+                    manager.in_use_.erase(ptr);
+                    manager.in_use_cv_.notify_all();
+                }
+            }
+        } guard {*this, ptr};
+
+        fn(*ptr);
+    }
+}
+
 template <typename C>
-void session_manager::signal_subscribe(const std::string& signal_name, C&& callable, const std::string& sender,
-                                       const std::string& interface_name, const object_path_t& object_path)
+signal_subscription session_manager::signal_subscribe(const std::string& signal_name, C&& callable,
+                                                      const std::string& sender, const std::string& interface_name,
+                                                      const object_path_t& object_path,
+                                                      const signal_delivery& delivery)
 {
     using std_function_type = decltype(std::function {std::forward<C>(callable)});
 
-    signal_handlers_[signal_name] = generate_signal_handler(std::forward<C>(callable), std_function_type {});
+    auto handler = generate_signal_handler(std::forward<C>(callable), std_function_type {});
+
+    auto id = run_in_context([&] {
+        return signal_table_->add(connection_, {sender, interface_name, object_path.generic_string(), signal_name},
+                                  std::move(handler), delivery);
+    });
+
+    return {signal_table_, id};
+}
+
+template <typename F>
+std::invoke_result_t<F> session_manager::run_in_context(F&& fn)
+{
+    if (!context_)
+        return fn();
+
+    std::packaged_task<std::invoke_result_t<F>()> task {std::forward<F>(fn)};
+    auto                                          result = task.get_future();
+
+    auto* call = new std::function<void()> {[&task] {
+        task();
+    }};
+
+    // Runs right away if this thread owns the context (i.e. this is the dispatch thread).
+    g_main_context_invoke_full(context_, G_PRIORITY_DEFAULT, run_task, call, free_task);
 
-    g_dbus_connection_signal_subscribe(connection_, sender.empty() ? nullptr : sender.c_str(),
-                                       interface_name.empty() ? nullptr : interface_name.c_str(), signal_name.c_str(),
-                                       object_path.empty() ? nullptr : object_path.generic_string().c_str(), nullptr,
-                                       G_DBUS_SIGNAL_FLAGS_NONE, on_signal, this, nullptr);
+    return result.get();
 }
 
 } // end of namespace easydbuspp
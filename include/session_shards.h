@@ -0,0 +1,77 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#ifndef __SESSION_SHARDS_H_INCLUDED__
+#define __SESSION_SHARDS_H_INCLUDED__
+
+#include "session_manager.h"
+#include "types.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace easydbuspp {
+
+/*!
+ * A set of session_managers, each with a private connection to the bus, to spread objects or proxies
+ * across. Every connection has its own socket and message queues, so one busy object (or proxy) doesn't
+ * hold the others' messages up. Use `dispatch_t::OWN_THREAD` to also give each shard its own dispatch
+ * thread.
+ *
+ * A bus name can only be owned by one connection at a time, so on the service side each shard owns a
+ * name of its own. Clients find the shard serving a path with `index_for()`, which is the same in every
+ * process that uses the same number of shards.
+ */
+class session_shards {
+
+public:
+    /*!
+     * Constructor. Opens `count` connections that don't own any bus names, for proxies.
+     *
+     * @param bus_type Which bus to connect to (the session or system bus).
+     * @param count    How many connections to open.
+     * @param dispatch (Optional) Which thread(s) the connections dispatch on.
+     * @throw          std::runtime_error
+     */
+    session_shards(bus_type_t bus_type, size_t count, dispatch_t dispatch = dispatch_t::MAIN_LOOP);
+
+    /*!
+     * Constructor. Opens a connection for each name in `bus_names`, and requests that name on it.
+     *
+     * @param bus_type  Which bus to connect to (the session or system bus).
+     * @param bus_names One bus name per shard. An empty name gives a shard that doesn't own a name (its
+     *                  objects are reachable through its `unique_bus_name()`).
+     * @param dispatch  (Optional) Which thread(s) the connections dispatch on.
+     * @throw           std::runtime_error
+     */
+    session_shards(bus_type_t bus_type, const std::vector<std::string>& bus_names,
+                   dispatch_t dispatch = dispatch_t::MAIN_LOOP);
+
+    session_shards(const session_shards&)            = delete;
+    session_shards& operator=(const session_shards&) = delete;
+
+    //! Returns the number of shards.
+    size_t size() const;
+
+    //! Returns shard number `index`.
+    session_manager& operator[](size_t index);
+
+    //! Returns the index of the shard that serves `object_path` (a stable hash of the path).
+    size_t index_for(const object_path_t& object_path) const;
+
+    //! Returns the shard that serves `object_path`.
+    session_manager& for_path(const object_path_t& object_path);
+
+    //! Returns the shards in turn (e.g. to spread proxies evenly). Thread-safe.
+    session_manager& next();
+
+private:
+    std::vector<std::unique_ptr<session_manager>> shards_;
+    std::atomic<size_t>                           next_ {0};
+};
+
+} // end of namespace easydbuspp
+
+#endif // __SESSION_SHARDS_H_INCLUDED__
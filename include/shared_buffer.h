@@ -0,0 +1,94 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#ifndef __SHARED_BUFFER_H_INCLUDED__
+#define __SHARED_BUFFER_H_INCLUDED__
+
+#include "types.h"
+#include <cstddef>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+namespace easydbuspp {
+
+/*!
+ * A read-only block of bytes that travels between processes as a sealed memfd rather than inside the
+ * D-Bus message. Only the file descriptor goes over the bus; the receiver maps the memory read-only,
+ * so multi-megabyte payloads neither hit message size limits nor get copied by the bus daemon. Small
+ * payloads aren't worth a memfd and its system calls, so they travel inline instead. The D-Bus type
+ * is `v`, holding either an `h` or an `ay`. Use it as a method parameter or return value.
+ *
+ * Copies are cheap and share the same memory.
+ */
+class shared_buffer {
+
+public:
+    //! Payloads up to this size travel inside the message, unless told otherwise.
+    static constexpr size_t DEFAULT_INLINE_THRESHOLD = 16 * 1024;
+
+    //! An empty buffer.
+    shared_buffer() = default;
+
+    /*!
+     * Copies `size` bytes from `data` into a new memfd, then seals it so that it can no longer
+     * be written to, grown or shrunk. Payloads of at most `inline_threshold` bytes are kept in
+     * memory and sent inline instead (0 always uses a memfd).
+     *
+     * @throw std::runtime_error
+     */
+    shared_buffer(const void* data, size_t size, size_t inline_threshold = DEFAULT_INLINE_THRESHOLD);
+
+    //! Same as above, for a byte vector.
+    explicit shared_buffer(const std::vector<std::byte>& bytes, size_t inline_threshold = DEFAULT_INLINE_THRESHOLD);
+
+    //! The mapped bytes (`nullptr` for an empty buffer).
+    const std::byte* data() const;
+
+    //! The number of mapped bytes.
+    size_t size() const;
+
+    bool empty() const { return size() == 0; }
+
+    const std::byte* begin() const { return data(); }
+    const std::byte* end() const { return data() + size(); }
+
+private:
+    struct region;
+
+    // Takes ownership of a received memfd. Refuses it unless it is sealed against writes and
+    // shrinking, since otherwise the sender could still change it (or pull it from under us).
+    static shared_buffer adopt(int fd);
+
+    // True if the bytes travel inside the message (as an `ay`), rather than as a memfd.
+    bool inline_bytes() const;
+
+    int fd() const;
+
+    // Returns a floating `v` GVariant. A memfd-backed buffer must have been added to an fd list first.
+    GVariant* encode() const;
+
+    // Inline bytes are taken right away, a memfd only as far as its fd index (see adopt()).
+    static shared_buffer decode(GVariant* v);
+
+    template <typename... A>
+    friend GUnixFDList* extract_g_unix_fd_list(std::tuple<A...>& input);
+
+    template <typename... A>
+    friend void set_up_from_g_unix_fd_list(GUnixFDList* fd_list, std::tuple<A...>& inout);
+
+    template <typename T>
+    friend std::decay_t<T> from_gvariant(GVariant* v);
+
+    template <typename T>
+    friend GVariant* to_gvariant(const T& t);
+
+private:
+    std::shared_ptr<const region> region_;
+    gint32                        fd_index_ {-1}; // Index in the message's fd list, while on the wire.
+};
+
+} // end of namespace easydbuspp
+
+#endif // __SHARED_BUFFER_H_INCLUDED__
@@ -0,0 +1,85 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#ifndef __SIGNAL_SUBSCRIPTION_H_INCLUDED__
+#define __SIGNAL_SUBSCRIPTION_H_INCLUDED__
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace easydbuspp {
+
+class signal_table;
+
+//! Where (on which thread) a signal callback gets called.
+enum class signal_delivery_t {
+    INLINE,      //!< On the thread dispatching D-Bus events, which waits for it to return. The default.
+    THREAD_POOL, //!< On a shared thread pool. Signals may be handled concurrently, and out of order.
+    STRAND,      //!< On the shared thread pool, but one at a time and in the order they were received.
+    QUEUE        //!< On a dedicated thread, fed through a bounded queue.
+};
+
+//! How a signal callback gets called (see session_manager::signal_subscribe()).
+struct signal_delivery {
+    static constexpr size_t DEFAULT_QUEUE_CAPACITY = 1024;
+
+    signal_delivery(signal_delivery_t delivery_mode = signal_delivery_t::INLINE,
+                    size_t delivery_queue_capacity = DEFAULT_QUEUE_CAPACITY)
+        : mode {delivery_mode}, queue_capacity {delivery_queue_capacity}
+    {
+    }
+
+    signal_delivery_t mode;
+    //! QUEUE only: when this many signals are waiting, the oldest one is dropped to make room.
+    size_t queue_capacity;
+};
+
+/*!
+ * Handle to a signal subscription, as returned by `session_manager::signal_subscribe()`. The callback
+ * stays subscribed for as long as the handle is alive (or until `unsubscribe()`), unless the handle is
+ * `detach()`ed, in which case it stays subscribed for as long as the session_manager is.
+ *
+ * Handles may safely outlive their session_manager.
+ */
+class signal_subscription {
+
+public:
+    //! An empty handle, not associated with any subscription.
+    signal_subscription() = default;
+
+    //! Destructor. Unsubscribes, unless detached.
+    ~signal_subscription();
+
+    signal_subscription(signal_subscription&& other) noexcept;
+    signal_subscription& operator=(signal_subscription&& other) noexcept;
+
+    signal_subscription(const signal_subscription&)            = delete;
+    signal_subscription& operator=(const signal_subscription&) = delete;
+
+    /*!
+     * Removes the callback, and waits for the calls to it that are already running to return. Signals it
+     * hasn't been called for yet are dropped. Called from the callback itself, it doesn't wait.
+     */
+    void unsubscribe();
+
+    //! Lets the subscription live on after the handle is gone, for as long as the session_manager.
+    void detach();
+
+    //! True if this handle still controls a subscription.
+    explicit operator bool() const { return id_ != 0; }
+
+private:
+    signal_subscription(std::weak_ptr<signal_table> table, uint64_t id) : table_ {std::move(table)}, id_ {id} { }
+
+private:
+    std::weak_ptr<signal_table> table_;
+    uint64_t                    id_ {0};
+
+    friend class session_manager;
+};
+
+} // end of namespace easydbuspp
+
+#endif // __SIGNAL_SUBSCRIPTION_H_INCLUDED__
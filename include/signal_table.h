@@ -0,0 +1,94 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#ifndef __SIGNAL_TABLE_H_INCLUDED__
+#define __SIGNAL_TABLE_H_INCLUDED__
+
+#include "g_thread_pool.h"
+#include "signal_subscription.h"
+#include "types.h"
+#include <cstdint>
+#include <functional>
+#include <gio/gio.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace easydbuspp {
+
+//! What a signal subscription matches on. Empty fields match anything.
+struct signal_key {
+    std::string sender;
+    std::string interface_name;
+    std::string object_path;
+    std::string signal_name;
+
+    bool operator==(const signal_key& other) const
+    {
+        return sender == other.sender && interface_name == other.interface_name && object_path == other.object_path
+            && signal_name == other.signal_name;
+    }
+};
+
+struct signal_key_hash {
+    size_t operator()(const signal_key& key) const;
+};
+
+/*!
+ * The signal subscriptions of a session_manager. Subscribers with the same key share a single GDBus
+ * subscription (a "route"), whose callback gets the route itself as user data, so dispatch does no
+ * lookups. Each route's subscriber list is copy-on-write: dispatch only holds the route lock for as
+ * long as it takes to copy a shared_ptr, and callbacks run unlocked, so they may (un)subscribe freely.
+ */
+class signal_table {
+
+public:
+    using handler_t = std::function<void(GVariant*)>;
+
+public:
+    signal_table() = default;
+
+    //! Destructor. Drops all GDBus subscriptions.
+    ~signal_table();
+
+    signal_table(const signal_table&)            = delete;
+    signal_table& operator=(const signal_table&) = delete;
+
+    //! Adds a subscriber and returns its ID (never 0).
+    uint64_t add(GDBusConnection* connection, const signal_key& key, handler_t handler,
+                 const signal_delivery& delivery = {});
+
+    //! Removes a subscriber. Unknown IDs are ignored.
+    void remove(uint64_t id);
+
+private:
+    struct delivery_queue;
+    struct subscriber;
+    struct route;
+
+    static void on_signal(GDBusConnection* connection, const gchar* sender_name, const gchar* object_path,
+                          const gchar* interface_name, const gchar* signal_name, GVariant* parameters,
+                          gpointer user_data);
+
+    static void free_route(gpointer user_data);
+
+    static void g_thread_pool_function(gpointer data, gpointer user_data);
+
+    // Drops the GDBus subscription, which eventually frees the route (see free_route()).
+    static void close_route(route* r);
+
+private:
+    std::mutex                                               mutex_;
+    uint64_t                                                 next_id_ {1};
+    std::unordered_map<signal_key, route*, signal_key_hash> routes_;
+    std::unordered_map<uint64_t, route*>                     subscriber_routes_;
+
+    // Shared by all THREAD_POOL and STRAND subscribers.
+    static g_thread_pool thread_pool_;
+};
+
+} // end of namespace easydbuspp
+
+#endif // __SIGNAL_TABLE_H_INCLUDED__
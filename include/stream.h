@@ -0,0 +1,145 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#ifndef __STREAM_H_INCLUDED__
+#define __STREAM_H_INCLUDED__
+
+#include "types.h"
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+
+namespace easydbuspp {
+
+class stream_reader;
+class stream_writer;
+
+/*!
+ * Creates a connected reader / writer pair. Return (or pass) either end from (to) a D-Bus method, and
+ * records written on one side come out, in order, on the other. Only the file descriptor goes over
+ * the bus (the D-Bus type is `h`), the data itself flows through a socket with backpressure: writes
+ * block while the reader falls behind.
+ *
+ * A typical use is a method that returns the reader right away, after handing the writer to a
+ * thread that produces the data.
+ *
+ * @throw std::runtime_error
+ */
+std::pair<stream_reader, stream_writer> make_stream();
+
+/*!
+ * The consuming end of a stream. Copies share the same underlying socket, which gets closed when
+ * the last copy goes away.
+ */
+class stream_reader {
+
+public:
+    //! The largest record `next()` accepts, unless told otherwise.
+    static constexpr size_t default_max_record_size {16 * 1024 * 1024};
+
+public:
+    //! An unconnected reader.
+    stream_reader() = default;
+
+    /*!
+     * Blocks until the next record is available.
+     *
+     * @return The next record, or `std::nullopt` once every writer has been closed.
+     * @throw  std::runtime_error (also for records larger than `max_record_size()`, after which the
+     *         stream can't be read anymore).
+     */
+    std::optional<std::string> next();
+
+    /*!
+     * Sets the largest record `next()` accepts (for every copy of this reader). The length comes from
+     * the peer, so this bounds how much memory a misbehaving writer can make us allocate.
+     *
+     * @throw std::runtime_error
+     */
+    void max_record_size(size_t size);
+
+    //! Returns the largest record `next()` accepts.
+    size_t max_record_size() const;
+
+private:
+    struct state;
+
+    explicit stream_reader(int fd);
+
+    static stream_reader adopt(int fd);
+
+    int fd() const;
+
+    template <typename... A>
+    friend GUnixFDList* extract_g_unix_fd_list(std::tuple<A...>& input);
+
+    template <typename... A>
+    friend void set_up_from_g_unix_fd_list(GUnixFDList* fd_list, std::tuple<A...>& inout);
+
+    template <typename T>
+    friend std::decay_t<T> from_gvariant(GVariant* v);
+
+    template <typename T>
+    friend GVariant* to_gvariant(const T& t);
+
+    friend std::pair<stream_reader, stream_writer> make_stream();
+
+private:
+    std::shared_ptr<state> state_;
+    gint32                 fd_index_ {-1}; // Index in the message's fd list, while on the wire.
+};
+
+/*!
+ * The producing end of a stream. Copies share the same underlying socket; the reader sees the end
+ * of the stream once `close()` has been called, or the last copy has gone away.
+ */
+class stream_writer {
+
+public:
+    //! An unconnected writer.
+    stream_writer() = default;
+
+    /*!
+     * Sends a record, blocking while the reader is behind.
+     *
+     * @throw std::runtime_error (also if the reader has gone away).
+     */
+    void write(const std::string& record);
+
+    //! Ends the stream (for every copy of this writer).
+    void close();
+
+private:
+    struct state;
+
+    explicit stream_writer(int fd);
+
+    static stream_writer adopt(int fd);
+
+    int fd() const;
+
+    template <typename... A>
+    friend GUnixFDList* extract_g_unix_fd_list(std::tuple<A...>& input);
+
+    template <typename... A>
+    friend void set_up_from_g_unix_fd_list(GUnixFDList* fd_list, std::tuple<A...>& inout);
+
+    template <typename T>
+    friend std::decay_t<T> from_gvariant(GVariant* v);
+
+    template <typename T>
+    friend GVariant* to_gvariant(const T& t);
+
+    friend std::pair<stream_reader, stream_writer> make_stream();
+
+private:
+    std::shared_ptr<state> state_;
+    gint32                 fd_index_ {-1}; // Index in the message's fd list, while on the wire.
+};
+
+} // end of namespace easydbuspp
+
+#endif // __STREAM_H_INCLUDED__
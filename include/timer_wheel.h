@@ -0,0 +1,83 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#ifndef __TIMER_WHEEL_H_INCLUDED__
+#define __TIMER_WHEEL_H_INCLUDED__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+
+namespace easydbuspp {
+
+/*!
+ * A hierarchical timer wheel: LEVELS wheels of SLOTS slots each, where a slot on level `n` covers
+ * SLOTS^n ticks. Inserting, erasing and expiring a timer are all O(1) (an entry is moved down one
+ * level at a time as its expiry gets closer). Timers further away than SLOTS^LEVELS ticks expire
+ * early, at the end of the wheel's range, so users needing longer timeouts should check and re-insert.
+ *
+ * Not thread-safe: callers are expected to do their own locking.
+ */
+template <typename K>
+class timer_wheel {
+
+    struct node {
+        K        key;
+        uint64_t expires;
+        size_t   level;
+        size_t   slot;
+    };
+
+public:
+    static constexpr size_t SLOT_BITS = 6;
+    static constexpr size_t SLOTS     = size_t {1} << SLOT_BITS;
+    static constexpr size_t LEVELS    = 4;
+
+    //! Identifies an inserted timer, until it expires or gets erased.
+    using handle = typename std::list<node>::iterator;
+
+public:
+    /*!
+     * Add a timer.
+     *
+     * @param key     Passed back to the `advance()` callback when the timer expires.
+     * @param expires The tick the timer expires on. Ticks in the past expire on the next tick.
+     * @return        A handle that can be used to `erase()` the timer before it expires.
+     */
+    handle insert(const K& key, uint64_t expires);
+
+    //! Remove a timer that has not expired yet.
+    void erase(handle h);
+
+    /*!
+     * Move time forward to tick `now`, calling `on_expired(key)` for every timer that expires on the
+     * way. The callback may insert new timers. If there are no timers, this simply jumps to `now`.
+     */
+    template <typename F>
+    void advance(uint64_t now, F&& on_expired);
+
+    //! True if there are no timers.
+    bool empty() const { return size_ == 0; }
+
+    //! Number of timers.
+    size_t size() const { return size_; }
+
+private:
+    // Works out the (level, slot) for `n`, relative to current_, and moves it there from `from`.
+    void place(std::list<node>& from, handle n, uint64_t earliest);
+
+    std::list<node>& slot(size_t level, size_t index) { return slots_[level * SLOTS + index]; }
+
+private:
+    std::array<std::list<node>, LEVELS * SLOTS> slots_;
+    uint64_t                                    current_ {0};
+    size_t                                      size_ {0};
+};
+
+} // end of namespace easydbuspp
+
+#include "timer_wheel.inl"
+
+#endif // __TIMER_WHEEL_H_INCLUDED__
@@ -0,0 +1,93 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#ifndef __TIMER_WHEEL_INL_INCLUDED__
+#define __TIMER_WHEEL_INL_INCLUDED__
+
+#include <utility>
+
+namespace easydbuspp {
+
+template <typename K>
+typename timer_wheel<K>::handle timer_wheel<K>::insert(const K& key, uint64_t expires)
+{
+    std::list<node> pending;
+    auto            n = pending.insert(pending.end(), node {key, expires, 0, 0});
+
+    // The current tick's slot has already expired, so the earliest a new timer can expire on is the next one.
+    place(pending, n, current_ + 1);
+    ++size_;
+
+    return n;
+}
+
+template <typename K>
+void timer_wheel<K>::erase(handle h)
+{
+    slot(h->level, h->slot).erase(h);
+    --size_;
+}
+
+template <typename K>
+template <typename F>
+void timer_wheel<K>::advance(uint64_t now, F&& on_expired)
+{
+    if (size_ == 0) {
+        if (now > current_)
+            current_ = now;
+        return;
+    }
+
+    while (current_ < now) {
+        ++current_;
+
+        // Every SLOTS^level ticks, the current slot of the level above gets spread over the levels below.
+        for (size_t level = 1; level < LEVELS; ++level) {
+            if ((current_ & ((uint64_t {1} << (SLOT_BITS * level)) - 1)) != 0)
+                break;
+
+            auto& cascading = slot(level, (current_ >> (SLOT_BITS * level)) & (SLOTS - 1));
+
+            // Timers expiring on this very tick go into the level 0 slot that's about to expire.
+            while (!cascading.empty())
+                place(cascading, cascading.begin(), current_);
+        }
+
+        std::list<node> expired;
+        expired.splice(expired.end(), slot(0, current_ & (SLOTS - 1)));
+        size_ -= expired.size();
+
+        for (auto&& n : expired)
+            on_expired(n.key);
+    }
+}
+
+template <typename K>
+void timer_wheel<K>::place(std::list<node>& from, handle n, uint64_t earliest)
+{
+    if (n->expires < earliest)
+        n->expires = earliest;
+
+    uint64_t delta = n->expires - current_;
+    size_t   level = 0;
+
+    while (level < LEVELS - 1 && delta >= (uint64_t {1} << (SLOT_BITS * (level + 1))))
+        ++level;
+
+    // Past the end of the wheel: expire as late as the wheel allows.
+    const uint64_t range = uint64_t {1} << (SLOT_BITS * LEVELS);
+
+    if (delta >= range)
+        n->expires = current_ + range - 1;
+
+    n->level = level;
+    n->slot  = (n->expires >> (SLOT_BITS * level)) & (SLOTS - 1);
+
+    auto& to = slot(n->level, n->slot);
+    to.splice(to.end(), from, n);
+}
+
+} // end of namespace easydbuspp
+
+#endif // __TIMER_WHEEL_INL_INCLUDED__
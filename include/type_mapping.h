@@ -14,6 +14,16 @@
 
 namespace easydbuspp {
 
+template <typename T>
+std::string to_dbus_type_string();
+
+// Works on the tuple type alone: the element types may well not be default constructible.
+template <typename T, size_t... I>
+std::string tuple_dbus_type_string(std::index_sequence<I...>)
+{
+    return "(" + (std::string {} + ... + to_dbus_type_string<std::tuple_element_t<I, T>>()) + ")";
+}
+
 template <typename T>
 std::string to_dbus_type_string()
 {
@@ -35,30 +45,30 @@ std::string to_dbus_type_string()
         return "d";
     else if constexpr (decay_same_v<T, std::byte>)
         return "y";
-    else if constexpr (decay_same_v<T, unix_fd_t>)
+    else if constexpr (decay_same_v<T, shared_buffer>)
+        return "v";
+    else if constexpr (decay_same_v<T, unix_fd_t> || is_fd_backed_v<T>)
         return "h";
-    else if constexpr (decay_same_v<T, std::string> || decay_same_v<T, const char*>)
+    else if constexpr (decay_same_v<T, std::string> || decay_same_v<T, std::pmr::string>
+                       || decay_same_v<T, const char*>)
         return "s";
     else if constexpr (decay_same_v<T, object_path_t>)
         return "o";
-    else if constexpr (is_variant_v<T>)
+    else if constexpr (is_variant_v<T> || decay_same_v<T, raw_variant>)
         return "v";
     else if constexpr (decay_same_v<T, bool>)
         return "b";
+    else if constexpr (decay_same_v<T, compressed_bytes>)
+        return "(yay)";
+    else if constexpr (is_lazy_v<T>)
+        return to_dbus_type_string<typename std::decay_t<T>::value_type>();
     else if constexpr (is_vector_v<T>)
         return "a" + to_dbus_type_string<typename std::decay_t<T>::value_type>();
-    else if constexpr (is_tuple_like_v<T>) {
-        std::decay_t<T> t;
-        std::string     ret {"("};
-
-        std::apply(
-            [&ret](auto&&... args) {
-                ((ret += to_dbus_type_string<decltype(args)>()), ...);
-            },
-            t);
-
-        return ret + ")";
-    } else if constexpr (is_map_like_v<T>)
+    else if constexpr (is_tuple_like_v<T>)
+        return tuple_dbus_type_string<std::decay_t<T>>(std::make_index_sequence<std::tuple_size_v<std::decay_t<T>>> {});
+    else if constexpr (is_dbus_struct_v<T>)
+        return to_dbus_type_string<dbus_struct_tuple_t<T>>();
+    else if constexpr (is_map_like_v<T>)
         return "a{" + to_dbus_type_string<typename std::decay_t<T>::key_type>()
             + to_dbus_type_string<typename std::decay_t<T>::mapped_type>() + "}";
     else if constexpr (std::is_void_v<T>)
@@ -68,7 +78,7 @@ std::string to_dbus_type_string()
 }
 
 template <typename T>
-std::string to_dbus_type_string(T)
+std::string to_dbus_type_string(const T&)
 {
     return to_dbus_type_string<T>();
 }
@@ -94,17 +104,21 @@ const GVariantType* to_dbus_type()
         return G_VARIANT_TYPE_DOUBLE;
     else if constexpr (decay_same_v<T, std::byte>)
         return G_VARIANT_TYPE_BYTE;
-    else if constexpr (decay_same_v<T, std::string>)
+    else if constexpr (decay_same_v<T, std::string> || decay_same_v<T, std::pmr::string>)
         return G_VARIANT_TYPE_STRING;
     else if constexpr (decay_same_v<T, object_path_t>)
         return G_VARIANT_TYPE_OBJECT_PATH;
-    else if constexpr (is_variant_v<T>)
+    else if constexpr (is_variant_v<T> || decay_same_v<T, raw_variant> || decay_same_v<T, shared_buffer>)
         return G_VARIANT_TYPE_VARIANT;
     else if constexpr (decay_same_v<T, bool>)
         return G_VARIANT_TYPE_BOOLEAN;
+    else if constexpr (decay_same_v<T, compressed_bytes>)
+        return G_VARIANT_TYPE("(yay)");
+    else if constexpr (is_lazy_v<T>)
+        return to_dbus_type<typename std::decay_t<T>::value_type>();
     else if constexpr (is_vector_v<T>)
         return G_VARIANT_TYPE_ARRAY;
-    else if constexpr (is_tuple_like_v<T>)
+    else if constexpr (is_tuple_like_v<T> || is_dbus_struct_v<T>)
         return G_VARIANT_TYPE_TUPLE;
     else if constexpr (is_map_like_v<T>)
         return G_VARIANT_TYPE_DICTIONARY;
@@ -115,11 +129,21 @@ const GVariantType* to_dbus_type()
 }
 
 template <typename T>
-const GVariantType* to_dbus_type(T)
+const GVariantType* to_dbus_type(const T&)
 {
     return to_dbus_type<T>();
 }
 
+//! Introspection annotations (as XML) for arguments of type T, e.g. to say how they are encoded on the wire.
+template <typename T>
+std::string dbus_annotations_xml()
+{
+    if constexpr (decay_same_v<T, compressed_bytes>)
+        return "    <annotation name='org.easydbuspp.Compression' value='zlib'/>\n";
+    else
+        return {};
+}
+
 } // end of namespace easydbuspp
 
 #endif // __TYPE_MAPPING_H_INCLUDED__
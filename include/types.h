@@ -9,10 +9,12 @@
 #include <gio/gio.h>
 #include <map>
 #include <memory>
+#include <memory_resource>
 #include <string>
 #include <tuple>
 #include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -21,6 +23,23 @@ namespace easydbuspp {
 //! The kinds of bus to connect to.
 enum class bus_type_t { SESSION, SYSTEM };
 
+//! Which thread a session_manager dispatches D-Bus events (method calls, property queries, signals) on.
+enum class dispatch_t {
+    MAIN_LOOP,  //!< The thread running the main_loop (the global default GMainContext).
+    OWN_THREAD, //!< A thread of its own, running a private GMainContext.
+};
+
+//! Which connection to the bus a session_manager uses.
+enum class connection_t {
+    SHARED,  //!< The process-wide connection GLib shares between everyone who asks for that bus.
+    PRIVATE, //!< A connection of its own, with its own socket (and unique bus name).
+};
+
+//! The D-Bus address of a peer_server (e.g. "unix:path=/run/my_service/socket"), to connect to directly.
+struct peer_address_t {
+    std::string address;
+};
+
 using object_path_t = std::filesystem::path;
 
 enum class unix_fd_t : gint32 {};
@@ -30,12 +49,59 @@ struct dbus_context {
     std::string   interface_name;
     object_path_t object_path;
     std::string   name;
+    void*         state {nullptr}; //!< The state pointer of the object serving the request, if any.
+
+    //! Returns `state`, cast to a `T*`.
+    template <typename T>
+    T* state_as() const
+    {
+        return static_cast<T*>(state);
+    }
 };
 
 using g_variant_ptr         = std::unique_ptr<GVariant, decltype(&g_variant_unref)>;
 using g_variant_builder_ptr = std::unique_ptr<GVariantBuilder, decltype(&g_variant_builder_unref)>;
 using g_dbus_node_info_ptr  = std::unique_ptr<GDBusNodeInfo, decltype(&g_dbus_node_info_unref)>;
 using g_unix_fd_list_ptr    = std::unique_ptr<GUnixFDList, decltype(&g_object_unref)>;
+using g_bytes_ptr           = std::unique_ptr<GBytes, decltype(&g_bytes_unref)>;
+
+/*!
+ * A reference counted, undecoded GVariant. As a method parameter, return value, signal argument or
+ * property it maps to the D-Bus `v` type, and its contents are relayed as-is: copying it, receiving
+ * it or sending it only costs a reference count bump, never a conversion to or from C++ types.
+ */
+class raw_variant {
+
+public:
+    raw_variant() = default;
+
+    //! Takes ownership of a reference to `value` (sinking it first, if it is floating).
+    explicit raw_variant(GVariant* value) : value_ {value ? g_variant_take_ref(value) : nullptr, g_variant_unref} { }
+
+    raw_variant(const raw_variant& other)
+        : value_ {other.value_ ? g_variant_ref(other.value_.get()) : nullptr, g_variant_unref}
+    {
+    }
+
+    raw_variant(raw_variant&&) = default;
+
+    raw_variant& operator=(raw_variant other)
+    {
+        value_ = std::move(other.value_);
+        return *this;
+    }
+
+    //! The wrapped value (no reference is transferred to the caller).
+    GVariant* get() const { return value_.get(); }
+
+    explicit operator bool() const { return value_ != nullptr; }
+
+private:
+    g_variant_ptr value_ {nullptr, g_variant_unref};
+};
+
+//! Interface name -> (property name -> value) map, as used by the `org.freedesktop.DBus.ObjectManager` interface.
+using interfaces_and_properties_t = std::map<std::string, std::map<std::string, raw_variant>>;
 
 template <typename U, typename V>
 constexpr bool decay_same_v = std::is_same_v<std::decay_t<U>, V>;
@@ -77,12 +143,79 @@ inline constexpr bool is_variant_v = is_specialization_of_v<std::decay_t<T>, std
 template <typename T>
 inline constexpr bool is_unordered_map_v = is_specialization_of_v<std::decay_t<T>, std::unordered_map>;
 
+template <typename T>
+class lazy;
+
+template <typename T>
+inline constexpr bool is_lazy_v = is_specialization_of_v<std::decay_t<T>, lazy>;
+
+template <typename T, typename = void>
+struct is_pmr_container : std::false_type {};
+
+template <typename T>
+struct is_pmr_container<T, std::void_t<typename T::allocator_type>>
+    : std::is_same<typename T::allocator_type, std::pmr::polymorphic_allocator<typename T::value_type>> {};
+
+//! True for containers that allocate through a `std::pmr::polymorphic_allocator` (`std::pmr::string` etc.).
+template <typename T>
+inline constexpr bool is_pmr_container_v = is_pmr_container<std::decay_t<T>>::value;
+
 template <typename T>
 inline constexpr bool is_tuple_like_v = is_tuple_v<T> || is_pair_v<T>;
 
+// The member pointers of an EASYDBUSPP_STRUCT() type, found via ADL in the struct's own namespace.
+template <typename T>
+using dbus_struct_members_t = decltype(easydbuspp_struct_members(static_cast<const T*>(nullptr)));
+
+template <typename T, typename = void>
+struct is_dbus_struct : std::false_type {};
+
+template <typename T>
+struct is_dbus_struct<T, std::void_t<dbus_struct_members_t<T>>> : std::true_type {};
+
+//! True for structs whose members have been listed with EASYDBUSPP_STRUCT() (the D-Bus `(...)` type).
+template <typename T>
+inline constexpr bool is_dbus_struct_v = is_dbus_struct<std::decay_t<T>>::value;
+
+template <typename T>
+struct member_pointer_value;
+
+template <typename C, typename V>
+struct member_pointer_value<V C::*> {
+    using type = V;
+};
+
+template <typename T>
+struct dbus_struct_tuple;
+
+template <typename... M>
+struct dbus_struct_tuple<std::tuple<M...>> {
+    using type = std::tuple<typename member_pointer_value<M>::type...>;
+};
+
+//! A tuple type with the same element types as the listed members of struct T (only used as a type).
+template <typename T>
+using dbus_struct_tuple_t = typename dbus_struct_tuple<dbus_struct_members_t<std::decay_t<T>>>::type;
+
 template <typename T>
 inline constexpr bool is_map_like_v = is_map_v<T> || is_unordered_map_v<T>;
 
+class compressed_bytes;
+class shared_buffer;
+class stream_reader;
+class stream_writer;
+
+//! Types that (may) travel as a file descriptor in the message's fd list.
+template <typename T>
+inline constexpr bool is_fd_backed_v
+    = decay_same_v<T, shared_buffer> || decay_same_v<T, stream_reader> || decay_same_v<T, stream_writer>;
+
+//! How arguments are held while being marshalled: scalars (fds, pointers) and fd-backed types by value (the
+//! fd list set-up rewrites them in place), everything else by reference.
+template <typename T>
+using marshalled_arg_t = std::conditional_t<std::is_scalar_v<std::decay_t<T>> || is_fd_backed_v<T>, std::decay_t<T>,
+                                            const std::decay_t<T>&>;
+
 inline GBusType to_g_bus_type(easydbuspp::bus_type_t bus_type)
 {
     switch (bus_type) {
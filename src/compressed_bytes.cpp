@@ -0,0 +1,123 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include <algorithm>
+#include <compressed_bytes.h>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace easydbuspp {
+
+namespace {
+
+enum class encoding_t : uint8_t { RAW = 0, ZLIB = 1 };
+
+// The D-Bus specification caps messages at 128 MiB, so nothing legitimate inflates past that.
+constexpr size_t MAX_INFLATED_SIZE = 128 * 1024 * 1024;
+
+using g_converter_ptr = std::unique_ptr<GConverter, decltype(&g_object_unref)>;
+
+std::vector<std::byte> convert(GConverter* converter, const std::byte* input, size_t input_size, size_t max_size)
+{
+    std::vector<std::byte> output(std::max<size_t>(input_size, 64));
+    size_t                 total_read {0}, total_written {0};
+
+    for (;;) {
+        GError* error {nullptr};
+        gsize   bytes_read {0}, bytes_written {0};
+
+        auto result = g_converter_convert(converter, input + total_read, input_size - total_read,
+                                          output.data() + total_written, output.size() - total_written,
+                                          G_CONVERTER_INPUT_AT_END, &bytes_read, &bytes_written, &error);
+
+        total_read += bytes_read;
+        total_written += bytes_written;
+
+        if (result == G_CONVERTER_FINISHED)
+            break;
+
+        if (result == G_CONVERTER_ERROR) {
+            if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_NO_SPACE)) {
+                std::string error_message = error->message;
+                g_error_free(error);
+
+                throw std::runtime_error("zlib conversion failed: " + error_message);
+            }
+
+            g_error_free(error);
+        }
+
+        if (total_written == output.size()) {
+            if (output.size() >= max_size)
+                throw std::runtime_error("zlib conversion output exceeds " + std::to_string(max_size) + " bytes!");
+
+            output.resize(std::min(output.size() * 2, max_size));
+        }
+    }
+
+    output.resize(total_written);
+    return output;
+}
+
+} // end of anonymous namespace
+
+GVariant* compressed_bytes::encode() const
+{
+    const std::byte* payload {bytes_.data()};
+    size_t           payload_size {bytes_.size()};
+    encoding_t       encoding {encoding_t::RAW};
+
+    std::vector<std::byte> compressed;
+
+    if (!bytes_.empty() && bytes_.size() >= threshold_) {
+        g_converter_ptr compressor {G_CONVERTER(g_zlib_compressor_new(G_ZLIB_COMPRESSOR_FORMAT_ZLIB, -1)),
+                                    g_object_unref};
+
+        // Not worth it (nor allowed to grow past the original) if the data doesn't compress.
+        try {
+            compressed = convert(compressor.get(), bytes_.data(), bytes_.size(), bytes_.size());
+        } catch (const std::runtime_error&) {
+            compressed.clear();
+        }
+
+        if (!compressed.empty() && compressed.size() < bytes_.size()) {
+            payload      = compressed.data();
+            payload_size = compressed.size();
+            encoding     = encoding_t::ZLIB;
+        }
+    }
+
+    GVariant* children[] = {g_variant_new_byte(static_cast<guint8>(encoding)),
+                            g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, payload, payload_size, 1)};
+
+    return g_variant_new_tuple(children, 2);
+}
+
+compressed_bytes compressed_bytes::decode(GVariant* v)
+{
+    g_variant_ptr encoding_value {g_variant_get_child_value(v, 0), g_variant_unref};
+    g_variant_ptr payload_value {g_variant_get_child_value(v, 1), g_variant_unref};
+
+    gsize       payload_size {0};
+    const auto* payload
+        = static_cast<const std::byte*>(g_variant_get_fixed_array(payload_value.get(), &payload_size, 1));
+
+    switch (static_cast<encoding_t>(g_variant_get_byte(encoding_value.get()))) {
+    case encoding_t::RAW:
+        return compressed_bytes {std::vector<std::byte>(payload, payload + payload_size)};
+
+    case encoding_t::ZLIB: {
+        g_converter_ptr decompressor {G_CONVERTER(g_zlib_decompressor_new(G_ZLIB_COMPRESSOR_FORMAT_ZLIB)),
+                                      g_object_unref};
+
+        return compressed_bytes {convert(decompressor.get(), payload, payload_size, MAX_INFLATED_SIZE)};
+    }
+    }
+
+    throw std::runtime_error("Unknown compressed_bytes encoding!");
+}
+
+} // end of namespace easydbuspp
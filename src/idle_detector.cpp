@@ -4,6 +4,7 @@
 
 #include <idle_detector.h>
 #include <object.h>
+#include <vector>
 
 namespace easydbuspp {
 
@@ -11,6 +12,17 @@ idle_detector::~idle_detector()
 {
     // TODO: I'm betting that the future::get() call in disable() won't throw.
     disable();
+
+    if (!wheel_future_.valid())
+        return;
+
+    {
+        std::lock_guard lock(wheel_mutex_);
+        wheel_stop_ = true;
+    }
+
+    wheel_cv_.notify_all();
+    wheel_future_.get();
 }
 
 idle_detector& idle_detector::instance()
@@ -24,6 +36,8 @@ void idle_detector::disable()
     if (!idle_future_.valid())
         return;
 
+    enabled_.store(false, std::memory_order_relaxed);
+
     {
         std::lock_guard lock(idle_mutex_);
         stop_ = true;
@@ -35,28 +49,138 @@ void idle_detector::disable()
         idle_future_.get();
 }
 
-void idle_detector::ping(const object_path_t& object_path)
+void idle_detector::ping(const object& obj)
 {
-    if (!idle_future_.valid())
+    auto&      state   = obj.idle_state_;
+    const bool watched = state.watched.load(std::memory_order_relaxed);
+    const bool global  = enabled_.load(std::memory_order_relaxed) && !state.exempt.load(std::memory_order_relaxed);
+
+    if (!watched && !global)
         return;
 
+    const auto timestamp = now();
+
+    // Watched objects are not rescheduled here: the wheel thread checks last_activity when their timer expires.
+    if (watched)
+        state.last_activity.store(timestamp, std::memory_order_relaxed);
+
+    if (global)
+        last_activity_.store(timestamp, std::memory_order_relaxed);
+}
+
+void idle_detector::exclude(const object& obj)
+{
+    obj.idle_state_.exempt.store(true, std::memory_order_relaxed);
+}
+
+void idle_detector::watch_for(const object& obj, std::chrono::steady_clock::duration timeout,
+                              std::function<void()> on_idle)
+{
     {
-        std::lock_guard lock(idle_mutex_);
+        std::lock_guard lock(wheel_mutex_);
+
+        const auto timestamp = now();
 
-        if (excluded_objects_.find(object_path) != excluded_objects_.end())
-            return;
+        // Nothing to expire, this just brings an idle wheel up to date.
+        if (wheel_.empty())
+            wheel_.advance(to_ticks(timestamp), [](const object*) {
+            });
 
-        request_ping_ = true;
+        obj.idle_state_.last_activity.store(timestamp, std::memory_order_relaxed);
+        obj.idle_state_.watched.store(true, std::memory_order_relaxed);
+
+        auto it = watched_objects_.find(&obj);
+
+        if (it != watched_objects_.end())
+            wheel_.erase(it->second.timer);
+
+        auto timer = wheel_.insert(&obj, to_ticks(timestamp + timeout.count()));
+
+        watched_objects_.insert_or_assign(&obj, watched_object {timeout, std::move(on_idle), timer});
+
+        if (!wheel_future_.valid())
+            wheel_future_ = std::async(std::launch::async, [this] {
+                wheel_loop();
+            });
     }
 
-    idle_cv_.notify_all();
+    wheel_cv_.notify_all();
 }
 
-void idle_detector::exclude(const object& obj)
+void idle_detector::unwatch(const object& obj)
+{
+    std::lock_guard lock(wheel_mutex_);
+
+    obj.idle_state_.watched.store(false, std::memory_order_relaxed);
+
+    auto it = watched_objects_.find(&obj);
+
+    if (it == watched_objects_.end())
+        return;
+
+    wheel_.erase(it->second.timer);
+    watched_objects_.erase(it);
+}
+
+void idle_detector::wheel_loop()
+{
+    std::unique_lock lock {wheel_mutex_};
+
+    while (!wheel_stop_) {
+        if (wheel_.empty()) {
+            wheel_cv_.wait(lock, [this] {
+                return wheel_stop_ || !wheel_.empty();
+            });
+            continue;
+        }
+
+        if (wheel_cv_.wait_for(lock, WHEEL_TICK, [this] {
+                return wheel_stop_;
+            }))
+            break;
+
+        const auto                         timestamp = now();
+        std::vector<std::function<void()>> idle_callbacks;
+
+        wheel_.advance(to_ticks(timestamp), [&](const object* obj) {
+            auto& watched  = watched_objects_.at(obj);
+            auto  deadline = obj->idle_state_.last_activity.load(std::memory_order_relaxed) + watched.timeout.count();
+
+            // Pinged since the timer was set: try again at the new deadline.
+            if (deadline > timestamp) {
+                watched.timer = wheel_.insert(obj, to_ticks(deadline));
+                return;
+            }
+
+            obj->idle_state_.watched.store(false, std::memory_order_relaxed);
+            idle_callbacks.push_back(std::move(watched.on_idle));
+            watched_objects_.erase(obj);
+        });
+
+        if (idle_callbacks.empty())
+            continue;
+
+        // The callbacks may well destroy their objects, which calls unwatch().
+        lock.unlock();
+
+        for (auto&& on_idle : idle_callbacks)
+            on_idle();
+
+        lock.lock();
+    }
+}
+
+std::chrono::steady_clock::rep idle_detector::now()
+{
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+uint64_t idle_detector::to_ticks(std::chrono::steady_clock::rep timestamp)
 {
-    std::lock_guard lock(idle_mutex_);
+    // Rounded up, so that timers never expire early.
+    const auto tick = std::chrono::duration_cast<std::chrono::steady_clock::duration>(WHEEL_TICK).count();
 
-    excluded_objects_.insert(obj.object_path());
+    return (timestamp + tick - 1) / tick;
 }
 
 } // end of namespace easydbuspp
@@ -0,0 +1,124 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include <interface_definition.h>
+#include <object.h>
+#include <stdexcept>
+
+namespace easydbuspp {
+
+interface_definition::interface_definition(const std::string& name)
+    : name_ {name}, introspection_data_ {nullptr, g_dbus_node_info_unref}
+{
+}
+
+interface_definition::interface_definition(const interface_definition& other)
+    : name_ {other.name_}, introspection_data_ {nullptr, g_dbus_node_info_unref}
+{
+    std::lock_guard lock {other.introspection_mutex_};
+
+    methods_xml_    = other.methods_xml_;
+    properties_xml_ = other.properties_xml_;
+    signals_xml_    = other.signals_xml_;
+    methods_        = other.methods_;
+    properties_     = other.properties_;
+}
+
+std::string interface_definition::name() const
+{
+    return name_;
+}
+
+std::string interface_definition::introspection_xml() const
+{
+    std::lock_guard lock {introspection_mutex_};
+
+    return build_introspection_xml();
+}
+
+std::string interface_definition::build_introspection_xml() const
+{
+    return "<node>\n <interface name='" + name_ + "'>\n" + methods_xml_ + properties_xml_ + signals_xml_
+        + " </interface>\n</node>";
+}
+
+GDBusInterfaceInfo* interface_definition::interface_info() const
+{
+    std::lock_guard lock {introspection_mutex_};
+
+    frozen_ = true;
+
+    if (introspection_data_)
+        return introspection_data_->interfaces[0];
+
+    GError* error {nullptr};
+
+    introspection_data_ = g_dbus_node_info_ptr {
+        g_dbus_node_info_new_for_xml(build_introspection_xml().c_str(), &error), g_dbus_node_info_unref};
+
+    if (!introspection_data_) {
+        std::string error_message = error->message;
+        g_error_free(error);
+
+        throw std::runtime_error("Could not initialize introspection XML: " + error_message);
+    }
+
+    return introspection_data_->interfaces[0];
+}
+
+bool interface_definition::frozen() const
+{
+    std::lock_guard lock {introspection_mutex_};
+
+    return frozen_;
+}
+
+void interface_definition::add_method_entry(const std::string& name, method_handler_t handler,
+                                            const std::string& method_xml)
+{
+    std::lock_guard lock {introspection_mutex_};
+
+    throw_if_frozen();
+
+    methods_[name] = std::move(handler);
+    methods_xml_ += method_xml;
+    introspection_data_.reset();
+}
+
+void interface_definition::add_property_entry(const std::string& name, property_read_handler_t read_handler,
+                                              property_write_handler_t write_handler, const std::string& type,
+                                              const char* access)
+{
+    std::lock_guard lock {introspection_mutex_};
+
+    throw_if_frozen();
+
+    properties_[name] = {std::move(read_handler), std::move(write_handler)};
+    properties_xml_ += "  <property name='" + name + "' type='" + type + "' access='" + access + "'/>\n";
+    introspection_data_.reset();
+}
+
+void interface_definition::add_signal_entry(const std::string& signal_xml)
+{
+    std::lock_guard lock {introspection_mutex_};
+
+    throw_if_frozen();
+
+    signals_xml_ += signal_xml;
+    introspection_data_.reset();
+}
+
+void interface_definition::throw_if_frozen() const
+{
+    if (frozen_)
+        throw std::runtime_error("Interface '" + name_ + "' can't change while objects are serving it!");
+}
+
+void interface_definition::emit_signal(const object& obj, const std::string& interface_name,
+                                       const std::string& signal_name, const char* destination, GVariant* parameters)
+{
+    obj.emit_signal(interface_name, signal_name, destination, parameters);
+}
+
+} // end of namespace easydbuspp
@@ -2,30 +2,109 @@
 //
 // SPDX-License-Identifier: AGPL-3.0-only
 
+#include <algorithm>
 #include <idle_detector.h>
+#include <mutex>
 #include <object.h>
 #include <stdexcept>
 
 namespace easydbuspp {
 
+// Property changes waiting to be sent as one PropertiesChanged signal. Shared with the flush timer,
+// which may fire after the object is gone (owner is nullptr then).
+struct object::pending_property_changes {
+    using path_and_interface_t = std::pair<object_path_t, std::string>;
+
+    std::mutex                                                           mutex;
+    const object*                                                        owner {nullptr};
+    std::chrono::milliseconds                                            window {0};
+    std::map<path_and_interface_t, std::map<std::string, g_variant_ptr>> values;
+    bool                                                                 flush_scheduled {false};
+
+    // Sends everything and clears it.
+    void flush()
+    {
+        if (owner)
+            for (auto&& [path_and_interface, interface_values] : values)
+                owner->emit_properties_changed(path_and_interface.first, path_and_interface.second, interface_values);
+
+        values.clear();
+    }
+};
+
+// The idle source that registers an object's changes. It may run after the object is gone (owner is nullptr then).
+struct object::pending_registration {
+    std::mutex        mutex;
+    object*           owner {nullptr};
+    std::atomic<bool> scheduled {false};
+};
+
 g_thread_pool object::thread_pool_ {g_thread_pool_function};
 
 object::object(session_manager& session_mgr, const std::string& interface_name, const object_path_t& object_path)
-    : session_manager_ {session_mgr}, interface_name_ {interface_name}, object_path_ {object_path},
-      introspection_data_ {nullptr, g_dbus_node_info_unref}
+    : object {session_mgr, object_path, std::make_shared<interface_definition>(interface_name)}
 {
     session_manager_.attach(this);
 }
 
-object::~object()
+object::object(session_manager& session_mgr, const std::string& interface_name, const object_path_t& object_path,
+               const lookup_child_t& lookup_child, const enumerate_children_t& enumerate_children)
+    : object {session_mgr, object_path, std::make_shared<interface_definition>(interface_name)}
 {
-    session_manager_.detach(this);
+    if (!lookup_child)
+        throw std::runtime_error("Subtree object '" + object_path.generic_string()
+                                 + "' needs a child lookup function!");
+
+    lookup_child_       = lookup_child;
+    enumerate_children_ = enumerate_children;
+
+    session_manager_.attach(this);
 }
 
-std::string object::introspection_xml() const
+object::object(session_manager& session_mgr, std::shared_ptr<const interface_definition> definition,
+               const object_path_t& object_path, void* state)
+    : session_manager_ {session_mgr}, object_path_ {object_path}, interface_ {std::move(definition)},
+      interface_name_ {interface_ ? interface_->name_ : ""}, registration_ {std::make_shared<pending_registration>()},
+      state_ {state}, property_changes_ {std::make_shared<pending_property_changes>()}
 {
-    return "<node>\n <interface name='" + interface_name_ + "'>\n" + methods_xml_ + properties_xml_ + signals_xml_
-        + " </interface>\n</node>";
+    if (!interface_)
+        throw std::runtime_error("Object '" + object_path_.generic_string() + "' needs an interface definition!");
+
+    registration_->owner     = this;
+    property_changes_->owner = this;
+    session_manager_.attach(this);
+}
+
+object::object(session_manager& session_mgr, const object_path_t& object_path,
+               std::shared_ptr<interface_definition> own_definition)
+    : session_manager_ {session_mgr}, object_path_ {object_path}, interface_ {own_definition},
+      interface_name_ {own_definition->name_}, own_interface_ {own_definition},
+      registration_ {std::make_shared<pending_registration>()},
+      property_changes_ {std::make_shared<pending_property_changes>()}
+{
+    registration_->owner     = this;
+    property_changes_->owner = this;
+}
+
+object::~object()
+{
+    {
+        std::lock_guard lock {registration_->mutex};
+        registration_->owner = nullptr;
+    }
+
+    {
+        std::lock_guard lock {property_changes_->mutex};
+        property_changes_->owner = nullptr;
+    }
+
+    for (auto&& detach : cell_detachers_)
+        detach();
+
+    if (idle_state_.watched.load(std::memory_order_relaxed))
+        idle_detector::instance().unwatch(*this);
+
+    session_manager_.detach(this);
 }
 
 std::string object::interface_name() const
@@ -33,46 +112,341 @@ std::string object::interface_name() const
     return interface_name_;
 }
 
+std::vector<std::string> object::interface_names() const
+{
+    std::vector<std::string> names;
+
+    for (auto&& definition : interfaces())
+        names.push_back(definition->name_);
+
+    return names;
+}
+
+void object::add_interface(std::shared_ptr<const interface_definition> definition)
+{
+    if (!definition)
+        throw std::runtime_error("Object '" + object_path_.generic_string() + "' can't add a null interface!");
+
+    // Parse the introspection XML now, rather than when a request comes in.
+    definition->interface_info();
+
+    {
+        std::lock_guard lock {interfaces_mutex_};
+
+        if (definition->name_ == interface_name_
+            || std::any_of(extra_interfaces_.begin(), extra_interfaces_.end(), [&definition](auto&& extra) {
+                   return extra->name_ == definition->name_;
+               }))
+            throw std::runtime_error("Object '" + object_path_.generic_string() + "' already implements interface '"
+                                     + definition->name_ + "'!");
+
+        extra_interfaces_.push_back(definition);
+    }
+
+    schedule_registration();
+}
+
+void object::remove_interface(const std::string& interface_name)
+{
+    guint registration_id {0};
+
+    {
+        std::lock_guard lock {interfaces_mutex_};
+
+        auto it = std::find_if(extra_interfaces_.begin(), extra_interfaces_.end(), [&interface_name](auto&& extra) {
+            return extra->name_ == interface_name;
+        });
+
+        if (it == extra_interfaces_.end())
+            throw std::runtime_error("Object '" + object_path_.generic_string() + "' has no added interface '"
+                                     + interface_name + "'!");
+
+        extra_interfaces_.erase(it);
+
+        if (auto id_it = registration_ids_.find(interface_name); id_it != registration_ids_.end() && !lookup_child_) {
+            registration_id = id_it->second;
+            registration_ids_.erase(id_it);
+        }
+    }
+
+    if (registration_id == 0)
+        return;
+
+    g_dbus_connection_unregister_object(session_manager_.connection_, registration_id);
+    session_manager_.interfaces_removed(*this, {interface_name});
+}
+
+std::shared_ptr<const interface_definition> object::find_interface(const std::string& interface_name) const
+{
+    std::lock_guard lock {interfaces_mutex_};
+
+    if (interface_name_ == interface_name)
+        return interface_;
+
+    for (auto&& definition : extra_interfaces_)
+        if (definition->name_ == interface_name)
+            return definition;
+
+    return nullptr;
+}
+
+std::vector<std::shared_ptr<const interface_definition>> object::interfaces() const
+{
+    std::lock_guard lock {interfaces_mutex_};
+
+    std::vector<std::shared_ptr<const interface_definition>> definitions {interface_};
+    definitions.insert(definitions.end(), extra_interfaces_.begin(), extra_interfaces_.end());
+
+    return definitions;
+}
+
+bool object::registered() const
+{
+    std::lock_guard lock {interfaces_mutex_};
+
+    return !registration_ids_.empty();
+}
+
 object_path_t object::object_path() const
 {
     return object_path_;
 }
 
+void object::publish_own_interface()
+{
+    std::lock_guard own_lock {own_interface_mutex_};
+
+    if (!own_interface_)
+        return;
+
+    // Parse the introspection XML now, rather than when a request comes in.
+    own_interface_->interface_info();
+
+    std::lock_guard lock {interfaces_mutex_};
+    interface_ = own_interface_;
+}
+
 void object::pre_request_handler(const pre_request_handler_t& handler)
 {
     pre_request_handler_ = handler;
 }
 
-void object::connect()
+void object::coalesce_property_changes(std::chrono::milliseconds window)
+{
+    {
+        std::lock_guard lock {property_changes_->mutex};
+        property_changes_->window = window;
+    }
+
+    // Whatever was batched under the old window shouldn't wait for the new one.
+    flush_property_changes();
+}
+
+void object::flush_property_changes()
+{
+    std::lock_guard lock {property_changes_->mutex};
+
+    property_changes_->flush();
+}
+
+void object::cache_property_values(bool cache)
+{
+    std::lock_guard lock {property_cache_mutex_};
+
+    cache_values_ = cache;
+    property_cache_.clear();
+}
+
+void object::invalidate_property_value(const std::string& name)
+{
+    std::lock_guard lock {property_cache_mutex_};
+
+    property_cache_.erase(name);
+}
+
+void object::skip_unchanged_property_writes(bool skip)
+{
+    std::lock_guard lock {property_cache_mutex_};
+
+    skip_no_ops_ = skip;
+
+    if (!skip)
+        last_written_values_.clear();
+}
+
+std::vector<std::shared_ptr<const interface_definition>> object::connect()
 {
     if (!session_manager_.connection_)
         throw std::runtime_error("Invalid input when attempting object connect");
 
+    publish_own_interface();
+
+    auto definitions = interfaces();
+
+    if (!lookup_child_) {
+        std::vector<std::shared_ptr<const interface_definition>> added;
+
+        for (auto&& definition : definitions) {
+            guint previous_id {0};
+
+            {
+                std::lock_guard lock {interfaces_mutex_};
+
+                if (auto it = registration_ids_.find(definition->name_); it == registration_ids_.end())
+                    added.push_back(definition);
+                else if (definition->name_ == interface_name_ && definition != registered_interface_) {
+                    previous_id = it->second;
+                    registration_ids_.erase(it);
+                    registered_interface_.reset();
+                } else
+                    continue;
+            }
+
+            // A changed own interface is registered again in a single step on the dispatch thread, so the object
+            // (and its other interfaces) stay on the bus throughout. GDBus can't swap a registration in place, though.
+            session_manager_.run_in_context([this, &definition, previous_id] {
+                if (previous_id != 0)
+                    g_dbus_connection_unregister_object(session_manager_.connection_, previous_id);
+
+                register_interface(definition);
+            });
+        }
+
+        return added;
+    }
+
+    // Subtrees hand their interfaces to GDBus on each request, so they're only registered once.
+    if (registered())
+        return {};
+
+    // Parse the introspection XML now, rather than when a request comes in.
+    for (auto&& definition : definitions)
+        definition->interface_info();
+
     GError* error {nullptr};
+    guint   registration_id = session_manager_.run_in_context([this, &error] {
+        return g_dbus_connection_register_subtree(session_manager_.connection_, object_path_.generic_string().c_str(),
+                                                  &subtree_vtable_, G_DBUS_SUBTREE_FLAGS_DISPATCH_TO_UNENUMERATED_NODES,
+                                                  this, nullptr, &error);
+    });
+
+    if (registration_id == 0) {
+        std::string error_message = error->message;
+        g_error_free(error);
+
+        throw std::runtime_error("Could not register object '" + object_path_.generic_string() + "': " + error_message);
+    }
+
+    std::lock_guard lock {interfaces_mutex_};
 
-    introspection_data_ = g_dbus_node_info_ptr {g_dbus_node_info_new_for_xml(introspection_xml().c_str(), &error),
-                                                g_dbus_node_info_unref};
+    // A subtree has a single registration, for all its interfaces.
+    registration_ids_[interface_name_] = registration_id;
+
+    return {};
+}
+
+void object::register_interface(const std::shared_ptr<const interface_definition>& definition)
+{
+    GError* error {nullptr};
+    guint   registration_id = session_manager_.run_in_context([this, &definition, &error] {
+        return g_dbus_connection_register_object(session_manager_.connection_, object_path_.generic_string().c_str(),
+                                                 definition->interface_info(), &interface_vtable_, this, nullptr,
+                                                 &error);
+    });
 
-    if (!introspection_data_) {
+    if (registration_id == 0) {
         std::string error_message = error->message;
         g_error_free(error);
 
-        throw std::runtime_error("Could not initialize introspection XML: " + error_message);
+        throw std::runtime_error("Could not register interface '" + definition->name_ + "' of object '"
+                                 + object_path_.generic_string() + "': " + error_message);
     }
 
-    registration_id_ = g_dbus_connection_register_object(
-        session_manager_.connection_, object_path_.generic_string().c_str(), introspection_data_->interfaces[0],
-        &interface_vtable_, this, nullptr, nullptr);
+    std::lock_guard lock {interfaces_mutex_};
+
+    registration_ids_[definition->name_] = registration_id;
+
+    if (definition->name_ == interface_name_)
+        registered_interface_ = definition;
 }
 
 void object::disconnect()
 {
+    std::map<std::string, guint> registration_ids;
+
+    {
+        std::lock_guard lock {interfaces_mutex_};
+        registration_ids.swap(registration_ids_);
+        registered_interface_.reset();
+    }
+
     if (!session_manager_.connection_)
         return;
 
-    g_dbus_connection_unregister_object(session_manager_.connection_, registration_id_);
-    registration_id_             = 0;
-    session_manager_.connection_ = nullptr;
+    for (auto&& [interface_name, registration_id] : registration_ids) {
+        if (lookup_child_)
+            g_dbus_connection_unregister_subtree(session_manager_.connection_, registration_id);
+        else
+            g_dbus_connection_unregister_object(session_manager_.connection_, registration_id);
+    }
+}
+
+void object::schedule_registration()
+{
+    // Already scheduled: that run will pick this change up, too.
+    if (registration_->scheduled.exchange(true))
+        return;
+
+    GSource* source = g_idle_source_new();
+    g_source_set_priority(source, G_PRIORITY_DEFAULT);
+    g_source_set_callback(source, on_registration_idle, new std::shared_ptr<pending_registration> {registration_},
+                          free_registration_ref);
+    g_source_attach(source, session_manager_.context_);
+    g_source_unref(source);
+}
+
+void object::sync_registration()
+{
+    // If there's no connection yet, on_bus_acquired() will connect the object.
+    if (!session_manager_.connection_)
+        return;
+
+    std::shared_ptr<const interface_definition> previous;
+
+    {
+        std::lock_guard lock {interfaces_mutex_};
+        previous = registered_interface_;
+    }
+
+    auto added = connect();
+
+    // Subtree children aren't announced, they come and go as the subtree's lookup function sees fit.
+    if (lookup_child_)
+        return;
+
+    if (!added.empty())
+        session_manager_.interfaces_added(*this, added);
+
+    std::shared_ptr<const interface_definition> current;
+
+    {
+        std::lock_guard lock {interfaces_mutex_};
+        current = registered_interface_;
+    }
+
+    if (!previous || !current || current == previous)
+        return;
+
+    // The own interface is already known to clients, so the properties it gained go out as changes.
+    auto                                 values = interfaces_and_properties(object_path_, {current}, {});
+    std::map<std::string, g_variant_ptr> new_values;
+
+    for (auto&& [property_name, value] : values[interface_name_])
+        if (previous->properties_.count(property_name) == 0)
+            new_values.emplace(property_name, g_variant_ptr {g_variant_ref(value.get()), g_variant_unref});
+
+    if (!new_values.empty())
+        emit_properties_changed(object_path_, interface_name_, new_values);
 }
 
 void object::handle_method_call(GDBusConnection* /* connection */, const gchar* sender, const gchar* object_path,
@@ -81,17 +455,24 @@ void object::handle_method_call(GDBusConnection* /* connection */, const gchar*
 {
     using namespace std::string_literals;
 
-    dbus_context context {sender, interface_name, object_path, method_name};
+    object* obj_ptr = static_cast<object*>(user_data);
+
+    // Peer-to-peer connections have no bus, and so no sender names either.
+    dbus_context context {sender ? sender : "", interface_name, object_path, method_name, obj_ptr->state_};
 
     thread_pool_.push(new std::function<void()> {[=] {
         try {
-            object* obj_ptr = static_cast<object*>(user_data);
+            idle_detector::instance().ping(*obj_ptr);
+
+            auto definition = obj_ptr->find_interface(interface_name);
 
-            idle_detector::instance().ping(obj_ptr->object_path());
+            if (!definition)
+                throw std::runtime_error("No interface '"s + interface_name + "' registered by object '"
+                                         + obj_ptr->object_path_.generic_string() + "'!");
 
-            auto it = obj_ptr->methods_.find(method_name);
+            auto it = definition->methods_.find(method_name);
 
-            if (it == obj_ptr->methods_.end())
+            if (it == definition->methods_.end())
                 throw std::runtime_error("No method '"s + method_name + "' registered by object '"
                                          + obj_ptr->object_path_.generic_string() + "'!");
 
@@ -121,11 +502,17 @@ GVariant* object::handle_get_property(GDBusConnection* /* connection */, const g
     try {
         object* obj_ptr = static_cast<object*>(user_data);
 
-        idle_detector::instance().ping(obj_ptr->object_path());
+        idle_detector::instance().ping(*obj_ptr);
+
+        auto definition = obj_ptr->find_interface(interface_name);
 
-        auto it = obj_ptr->properties_.find(property_name);
+        if (!definition)
+            throw std::runtime_error("No interface '"s + interface_name + "' registered by object '"
+                                     + obj_ptr->object_path_.generic_string() + "'!");
+
+        auto it = definition->properties_.find(property_name);
 
-        if (it == obj_ptr->properties_.end())
+        if (it == definition->properties_.end())
             throw std::runtime_error("No property '"s + property_name + "' registered by object '"
                                      + obj_ptr->object_path_.generic_string() + "'!");
 
@@ -135,12 +522,16 @@ GVariant* object::handle_get_property(GDBusConnection* /* connection */, const g
             throw std::runtime_error("Property '"s + property_name + "' for object '"
                                      + obj_ptr->object_path_.generic_string() + "' cannot be read!");
 
-        dbus_context context {sender, interface_name, object_path, property_name};
+        dbus_context context {sender ? sender : "", interface_name, object_path, property_name, obj_ptr->state_};
 
         if (obj_ptr->pre_request_handler_)
             obj_ptr->pre_request_handler_(request_type::GET_PROPERTY, context);
 
-        return getter();
+        // Only values of the object's own interface are cached (they're looked up by property name alone).
+        if (obj_ptr->cache_values_ && !obj_ptr->lookup_child_ && interface_name == obj_ptr->interface_name_)
+            return obj_ptr->cached_property_value(property_name, getter, context);
+
+        return getter(context);
 
     } catch (const std::exception& e) {
         g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED, "%s", e.what());
@@ -157,11 +548,17 @@ gboolean object::handle_set_property(GDBusConnection* /* connection */, const gc
     try {
         object* obj_ptr = static_cast<object*>(user_data);
 
-        idle_detector::instance().ping(obj_ptr->object_path());
+        idle_detector::instance().ping(*obj_ptr);
 
-        auto it = obj_ptr->properties_.find(property_name);
+        auto definition = obj_ptr->find_interface(interface_name);
+
+        if (!definition)
+            throw std::runtime_error("No interface '"s + interface_name + "' registered by object '"
+                                     + obj_ptr->object_path_.generic_string() + "'!");
 
-        if (it == obj_ptr->properties_.end())
+        auto it = definition->properties_.find(property_name);
+
+        if (it == definition->properties_.end())
             throw std::runtime_error("No property '"s + property_name + "' registered by object '"
                                      + obj_ptr->object_path_.generic_string() + "'!");
 
@@ -171,12 +568,36 @@ gboolean object::handle_set_property(GDBusConnection* /* connection */, const gc
             throw std::runtime_error("Property '"s + property_name + "' for object '"
                                      + obj_ptr->object_path_.generic_string() + "' is read only!");
 
-        dbus_context context {sender, interface_name, object_path, property_name};
+        dbus_context context {sender ? sender : "", interface_name, object_path, property_name, obj_ptr->state_};
 
         if (obj_ptr->pre_request_handler_)
             obj_ptr->pre_request_handler_(request_type::SET_PROPERTY, context);
 
-        return setter(value);
+        // Property names can't contain dots, so this is unique across interfaces.
+        const std::string qualified_name {interface_name + "."s + property_name};
+
+        if (obj_ptr->skip_no_ops_ && obj_ptr->property_unchanged(qualified_name, getter, value, context))
+            return TRUE;
+
+        gboolean ret = setter(value, context);
+
+        obj_ptr->invalidate_property_value(property_name);
+
+        if (!ret)
+            throw std::runtime_error("Property '"s + property_name + "' for object '"
+                                     + obj_ptr->object_path_.generic_string() + "' could not be set!");
+
+        // Write-only values are remembered per property, which doesn't work for subtree children.
+        if (obj_ptr->skip_no_ops_ && !getter && !obj_ptr->lookup_child_) {
+            std::lock_guard lock {obj_ptr->property_cache_mutex_};
+
+            obj_ptr->last_written_values_.insert_or_assign(
+                qualified_name, g_variant_ptr {g_variant_ref_sink(value), g_variant_unref});
+        }
+
+        obj_ptr->emit_properties_update_signal(context.object_path, interface_name, property_name, value);
+
+        return TRUE;
 
     } catch (const std::exception& e) {
         g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED, "%s", e.what());
@@ -192,14 +613,271 @@ void object::g_thread_pool_function(gpointer data, gpointer /* user_data */)
     (*method_ptr)();
 }
 
-void object::emit_properties_update_signal(const std::string& property_name, GVariant* value) const
+void object::emit_properties_update_signal(const object_path_t& object_path, const std::string& interface_name,
+                                           const std::string& property_name, GVariant* value) const
+{
+    std::lock_guard lock {property_changes_->mutex};
+    auto&           pending = *property_changes_;
+
+    // Overwrites the previous value (if any): only the latest one is worth sending.
+    pending.values[{object_path, interface_name}].insert_or_assign(
+        property_name, g_variant_ptr {g_variant_ref_sink(value), g_variant_unref});
+
+    if (pending.window.count() == 0) {
+        pending.flush();
+        return;
+    }
+
+    if (pending.flush_scheduled)
+        return;
+
+    pending.flush_scheduled = true;
+
+    GSource* source = g_timeout_source_new(pending.window.count());
+    g_source_set_callback(source, on_property_changes_timeout,
+                          new std::shared_ptr<pending_property_changes> {property_changes_},
+                          free_property_changes_ref);
+    g_source_attach(source, session_manager_.context_);
+    g_source_unref(source);
+}
+
+GVariant* object::cached_property_value(const std::string& property_name, const property_read_handler_t& getter,
+                                        const dbus_context& context)
 {
+    // The getter runs under the lock, so that an invalidation can't be overwritten by the value it invalidated.
+    std::lock_guard lock {property_cache_mutex_};
+
+    auto it = property_cache_.find(property_name);
+
+    if (it == property_cache_.end()) {
+        g_variant_ptr value {g_variant_take_ref(getter(context)), g_variant_unref};
+
+        if (!value)
+            return nullptr;
+
+        it = property_cache_.emplace(property_name, std::move(value)).first;
+    }
+
+    return g_variant_ref(it->second.get());
+}
+
+bool object::property_unchanged(const std::string& property_name, const property_read_handler_t& getter,
+                                GVariant* value, const dbus_context& context) const
+{
+    if (getter) {
+        g_variant_ptr current {g_variant_take_ref(getter(context)), g_variant_unref};
+        return current && g_variant_equal(current.get(), value);
+    }
+
+    std::lock_guard lock {property_cache_mutex_};
+
+    auto it = last_written_values_.find(property_name);
+
+    return it != last_written_values_.end() && g_variant_equal(it->second.get(), value);
+}
+
+void object::emit_properties_changed(const object_path_t& object_path, const std::string& interface_name,
+                                     const std::map<std::string, g_variant_ptr>& values) const
+{
+    if (!session_manager_.connection_)
+        return;
+
     g_variant_builder_ptr builder {g_variant_builder_new(G_VARIANT_TYPE_ARRAY), g_variant_builder_unref};
-    g_variant_builder_add(builder.get(), "{sv}", property_name.c_str(), value);
-    GVariant* property_update = g_variant_new("(sa{sv}as)", interface_name_.c_str(), builder.get(), nullptr);
 
-    g_dbus_connection_emit_signal(session_manager_.connection_, nullptr, object_path_.generic_string().c_str(),
+    for (auto&& [property_name, value] : values)
+        g_variant_builder_add(builder.get(), "{sv}", property_name.c_str(), value.get());
+
+    GVariant* property_update = g_variant_new("(sa{sv}as)", interface_name.c_str(), builder.get(), nullptr);
+
+    g_dbus_connection_emit_signal(session_manager_.connection_, nullptr, object_path.generic_string().c_str(),
                                   "org.freedesktop.DBus.Properties", "PropertiesChanged", property_update, nullptr);
 }
 
+void object::emit_signal(const std::string& interface_name, const std::string& signal_name, const char* destination,
+                         GVariant* parameters) const
+{
+    if (!session_manager_.connection_) {
+        g_variant_unref(g_variant_ref_sink(parameters));
+
+        throw std::runtime_error("Unable to send signal '" + signal_name
+                                 + "': the D-Bus connection needs to be established first!");
+    }
+
+    g_dbus_connection_emit_signal(session_manager_.connection_, destination, object_path_.c_str(),
+                                  interface_name.c_str(), signal_name.c_str(), parameters, nullptr);
+}
+
+bool object::child_exists(const std::string& node) const
+{
+    try {
+        return lookup_child_(node);
+    } catch (const std::exception& e) {
+        g_warning("Could not look up child '%s' of '%s': %s", node.c_str(), object_path_.c_str(), e.what());
+        return false;
+    }
+}
+
+void object::managed_objects(std::map<object_path_t, interfaces_and_properties_t>& managed_objects,
+                             const std::string&                                    sender) const
+{
+    // Until it's on the bus, the object's own definition may still be changing.
+    if (!registered())
+        return;
+
+    auto definitions = interfaces();
+
+    if (!lookup_child_) {
+        managed_objects[object_path_].merge(interfaces_and_properties(object_path_, definitions, sender));
+        return;
+    }
+
+    // Only the children a subtree can enumerate are known.
+    std::vector<std::string> children;
+
+    try {
+        if (enumerate_children_)
+            children = enumerate_children_();
+    } catch (const std::exception& e) {
+        g_warning("Could not enumerate the children of '%s': %s", object_path_.c_str(), e.what());
+    }
+
+    for (auto&& child : children) {
+        const object_path_t child_path {object_path_ / child};
+        managed_objects[child_path].merge(interfaces_and_properties(child_path, definitions, sender));
+    }
+}
+
+interfaces_and_properties_t
+object::interfaces_and_properties(const object_path_t&                                            object_path,
+                                  const std::vector<std::shared_ptr<const interface_definition>>& definitions,
+                                  const std::string&                                              sender) const
+{
+    interfaces_and_properties_t result;
+
+    for (auto&& definition : definitions) {
+        auto& values = result[definition->name_];
+
+        for (auto&& [property_name, handlers] : definition->properties_) {
+            auto&& getter = handlers.first;
+
+            if (!getter)
+                continue;
+
+            dbus_context context {sender, definition->name_, object_path, property_name, state_};
+
+            // Properties that can't be read (or that the pre-request handler refuses to show) are left out.
+            try {
+                if (pre_request_handler_)
+                    pre_request_handler_(request_type::GET_PROPERTY, context);
+
+                raw_variant value {getter(context)};
+
+                if (value)
+                    values.emplace(property_name, std::move(value));
+            } catch (const std::exception&) {
+            }
+        }
+    }
+
+    return result;
+}
+
+gboolean object::on_property_changes_timeout(gpointer user_data)
+{
+    auto&           pending = **static_cast<std::shared_ptr<pending_property_changes>*>(user_data);
+    std::lock_guard lock {pending.mutex};
+
+    pending.flush_scheduled = false;
+    pending.flush();
+
+    return G_SOURCE_REMOVE;
+}
+
+void object::free_property_changes_ref(gpointer user_data)
+{
+    delete static_cast<std::shared_ptr<pending_property_changes>*>(user_data);
+}
+
+gboolean object::on_registration_idle(gpointer user_data)
+{
+    auto&           pending = **static_cast<std::shared_ptr<pending_registration>*>(user_data);
+    std::lock_guard lock {pending.mutex};
+
+    // Changes made from here on need another run.
+    pending.scheduled = false;
+
+    if (!pending.owner)
+        return G_SOURCE_REMOVE;
+
+    try {
+        pending.owner->sync_registration();
+    } catch (const std::exception& e) {
+        g_warning("Could not register object '%s': %s", pending.owner->object_path_.c_str(), e.what());
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+void object::free_registration_ref(gpointer user_data)
+{
+    delete static_cast<std::shared_ptr<pending_registration>*>(user_data);
+}
+
+gchar** object::subtree_enumerate(GDBusConnection* /* connection */, const gchar* /* sender */,
+                                  const gchar* /* object_path */, gpointer user_data)
+{
+    object* obj_ptr = static_cast<object*>(user_data);
+
+    std::vector<std::string> children;
+
+    try {
+        if (obj_ptr->enumerate_children_)
+            children = obj_ptr->enumerate_children_();
+    } catch (const std::exception& e) {
+        g_warning("Could not enumerate the children of '%s': %s", obj_ptr->object_path_.c_str(), e.what());
+    }
+
+    gchar** nodes = g_new0(gchar*, children.size() + 1);
+
+    for (size_t i = 0; i < children.size(); ++i)
+        nodes[i] = g_strdup(children[i].c_str());
+
+    return nodes;
+}
+
+GDBusInterfaceInfo** object::subtree_introspect(GDBusConnection* /* connection */, const gchar* /* sender */,
+                                                const gchar* /* object_path */, const gchar* node,
+                                                gpointer user_data)
+{
+    object* obj_ptr = static_cast<object*>(user_data);
+
+    // The subtree's root itself has no interfaces, only children.
+    if (!node || !obj_ptr->child_exists(node))
+        return nullptr;
+
+    auto                 definitions = obj_ptr->interfaces();
+    GDBusInterfaceInfo** interfaces  = g_new0(GDBusInterfaceInfo*, definitions.size() + 1);
+
+    // The XML has already been parsed, when the subtree (or the interface) was registered.
+    for (size_t i = 0; i < definitions.size(); ++i)
+        interfaces[i] = g_dbus_interface_info_ref(definitions[i]->interface_info());
+
+    return interfaces;
+}
+
+const GDBusInterfaceVTable* object::subtree_dispatch(GDBusConnection* /* connection */, const gchar* /* sender */,
+                                                     const gchar* /* object_path */, const gchar* interface_name,
+                                                     const gchar* node, gpointer* out_user_data,
+                                                     gpointer user_data)
+{
+    object* obj_ptr = static_cast<object*>(user_data);
+
+    if (!node || !obj_ptr->find_interface(interface_name) || !obj_ptr->child_exists(node))
+        return nullptr;
+
+    *out_user_data = obj_ptr;
+
+    return &interface_vtable_;
+}
+
 } // end of namespace easydbuspp
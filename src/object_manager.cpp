@@ -0,0 +1,99 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include <mutex>
+#include <object_manager.h>
+#include <session_manager.h>
+
+namespace easydbuspp {
+
+object_manager::object_manager(session_manager& session_mgr, const object_path_t& object_path)
+    : session_manager_ {session_mgr}, object_ {session_mgr, INTERFACE_NAME, object_path}
+{
+    object_.add_method(
+        "GetManagedObjects",
+        [this](const dbus_context& context) {
+            return managed_objects(context.bus_name);
+        },
+        {}, {"object_paths_interfaces_and_properties"});
+
+    interfaces_added_ = object_.add_broadcast_signal<object_path_t, interfaces_and_properties_t>(
+        "InterfacesAdded", {"object_path", "interfaces_and_properties"});
+
+    interfaces_removed_ = object_.add_broadcast_signal<object_path_t, std::vector<std::string>>(
+        "InterfacesRemoved", {"object_path", "interfaces"});
+
+    session_manager_.attach(this);
+}
+
+object_manager::~object_manager()
+{
+    session_manager_.detach(this);
+}
+
+object_path_t object_manager::object_path() const
+{
+    return object_.object_path();
+}
+
+bool object_manager::manages(const object_path_t& object_path) const
+{
+    const std::string root {object_.object_path_.generic_string()};
+    const std::string path {object_path.generic_string()};
+    const std::string prefix {root == "/" ? root : root + "/"};
+
+    return path.size() > prefix.size() && path.compare(0, prefix.size(), prefix) == 0;
+}
+
+std::map<object_path_t, interfaces_and_properties_t> object_manager::managed_objects(const std::string& sender) const
+{
+    std::map<object_path_t, interfaces_and_properties_t> result;
+    std::vector<object*>                                 managed;
+
+    {
+        std::lock_guard lock {session_manager_.objects_mutex_};
+
+        for (auto&& obj_ptr : session_manager_.objects_) {
+            // A subtree's children are below its path, so a subtree at the manager's own path counts too.
+            if (manages(obj_ptr->object_path_)
+                || (obj_ptr->lookup_child_ && obj_ptr->object_path_ == object_.object_path_))
+                managed.push_back(obj_ptr);
+        }
+    }
+
+    // Reading the properties runs user code, which may create or destroy objects.
+    session_manager_.for_each_attached(managed, session_manager_.objects_, [&result, &sender](object& obj) {
+        obj.managed_objects(result, sender);
+    });
+
+    return result;
+}
+
+void object_manager::interfaces_added(const object&                                                   obj,
+                                      const std::vector<std::shared_ptr<const interface_definition>>& definitions)
+{
+    if (!manages(obj.object_path_))
+        return;
+
+    try {
+        // A broadcast has no particular recipient, so the pre-request handler sees an empty bus name.
+        interfaces_added_(obj.object_path_, obj.interfaces_and_properties(obj.object_path_, definitions, {}));
+    } catch (const std::exception& e) {
+        g_warning("Could not announce the interfaces of '%s': %s", obj.object_path_.c_str(), e.what());
+    }
+}
+
+void object_manager::interfaces_removed(const object& obj, const std::vector<std::string>& interface_names)
+{
+    if (!manages(obj.object_path_))
+        return;
+
+    try {
+        interfaces_removed_(obj.object_path_, interface_names);
+    } catch (const std::exception& e) {
+        g_warning("Could not announce the removal of '%s': %s", obj.object_path_.c_str(), e.what());
+    }
+}
+
+} // end of namespace easydbuspp
@@ -0,0 +1,325 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include <map>
+#include <mutex>
+#include <object_manager.h>
+#include <object_manager_client.h>
+#include <session_manager.h>
+#include <stdexcept>
+
+namespace easydbuspp {
+
+namespace {
+
+const char* const PROPERTIES_INTERFACE = "org.freedesktop.DBus.Properties";
+
+} // end of anonymous namespace
+
+struct object_manager_client::mirror {
+    // A signal that came in while a GetManagedObjects call was in progress.
+    struct pending_signal {
+        std::string   signal_name;
+        object_path_t object_path;
+        g_variant_ptr parameters;
+    };
+
+    // Handlers get called after the lock is released, so that they can read the mirror.
+    using notifications_t = std::vector<std::function<void()>>;
+
+    void apply(const std::string& signal_name, const object_path_t& object_path, GVariant* parameters,
+               notifications_t& notifications);
+
+    std::mutex                                           refresh_mutex;
+    std::mutex                                           mutex;
+    std::map<object_path_t, interfaces_and_properties_t> objects;
+    bool                                                 refreshing {false};
+    std::vector<pending_signal>                          pending;
+    interfaces_handler_t                                 interfaces_added_handler;
+    interfaces_handler_t                                 interfaces_removed_handler;
+    properties_handler_t                                 properties_changed_handler;
+};
+
+void object_manager_client::mirror::apply(const std::string& signal_name, const object_path_t& object_path,
+                                          GVariant* parameters, notifications_t& notifications)
+{
+    if (signal_name == "InterfacesAdded") {
+        auto path       = extract<object_path_t>(parameters, 0);
+        auto interfaces = extract<interfaces_and_properties_t>(parameters, 1);
+
+        std::vector<std::string> names;
+
+        for (auto&& [interface_name, properties] : interfaces) {
+            objects[path][interface_name] = std::move(properties);
+            names.push_back(interface_name);
+        }
+
+        if (interfaces_added_handler)
+            notifications.push_back([handler = interfaces_added_handler, path, names] {
+                handler(path, names);
+            });
+
+    } else if (signal_name == "InterfacesRemoved") {
+        auto path  = extract<object_path_t>(parameters, 0);
+        auto names = extract<std::vector<std::string>>(parameters, 1);
+
+        auto it = objects.find(path);
+
+        if (it == objects.end())
+            return;
+
+        for (auto&& interface_name : names)
+            it->second.erase(interface_name);
+
+        if (it->second.empty())
+            objects.erase(it);
+
+        if (interfaces_removed_handler)
+            notifications.push_back([handler = interfaces_removed_handler, path, names] {
+                handler(path, names);
+            });
+
+    } else if (signal_name == "PropertiesChanged") {
+        auto interface_name = extract<std::string>(parameters, 0);
+
+        // Only objects (and interfaces) the manager told us about are mirrored.
+        auto object_it = objects.find(object_path);
+
+        if (object_it == objects.end())
+            return;
+
+        auto interface_it = object_it->second.find(interface_name);
+
+        if (interface_it == object_it->second.end())
+            return;
+
+        auto changed     = extract<std::map<std::string, raw_variant>>(parameters, 1);
+        auto invalidated = extract<std::vector<std::string>>(parameters, 2);
+
+        std::vector<std::string> names;
+
+        for (auto&& [property_name, value] : changed) {
+            interface_it->second[property_name] = std::move(value);
+            names.push_back(property_name);
+        }
+
+        for (auto&& property_name : invalidated) {
+            interface_it->second.erase(property_name);
+            names.push_back(property_name);
+        }
+
+        if (properties_changed_handler)
+            notifications.push_back([handler = properties_changed_handler, object_path, interface_name, names] {
+                handler(object_path, interface_name, names);
+            });
+    }
+}
+
+object_manager_client::object_manager_client(session_manager& session_mgr, const std::string& bus_name,
+                                             const object_path_t& object_path)
+    : session_manager_ {session_mgr}, bus_name_ {bus_name}, object_path_ {object_path},
+      mirror_ {std::make_shared<mirror>()}
+{
+    GDBusConnection* connection = session_manager_.connection_;
+
+    if (!connection)
+        throw std::runtime_error("Could not create object manager client: no live D-Bus connection!");
+
+    // Subscribe before loading the objects, so that nothing that happens in between gets lost.
+    session_manager_.run_in_context([this, connection] {
+        manager_subscription_ = g_dbus_connection_signal_subscribe(
+            connection, bus_name_.c_str(), object_manager::INTERFACE_NAME, nullptr, object_path_.c_str(), nullptr,
+            G_DBUS_SIGNAL_FLAGS_NONE, on_signal, new std::shared_ptr<mirror>(mirror_), free_mirror_ref);
+
+        properties_subscription_ = g_dbus_connection_signal_subscribe(
+            connection, bus_name_.c_str(), PROPERTIES_INTERFACE, "PropertiesChanged", nullptr, nullptr,
+            G_DBUS_SIGNAL_FLAGS_NONE, on_signal, new std::shared_ptr<mirror>(mirror_), free_mirror_ref);
+    });
+
+    try {
+        refresh();
+    } catch (...) {
+        g_dbus_connection_signal_unsubscribe(connection, manager_subscription_);
+        g_dbus_connection_signal_unsubscribe(connection, properties_subscription_);
+        throw;
+    }
+}
+
+object_manager_client::~object_manager_client()
+{
+    g_dbus_connection_signal_unsubscribe(session_manager_.connection_, manager_subscription_);
+    g_dbus_connection_signal_unsubscribe(session_manager_.connection_, properties_subscription_);
+}
+
+void object_manager_client::refresh()
+{
+    std::lock_guard refresh_lock {mirror_->refresh_mutex};
+
+    {
+        std::lock_guard lock {mirror_->mutex};
+        mirror_->refreshing = true;
+    }
+
+    GError* error {nullptr};
+
+    g_variant_ptr result {g_dbus_connection_call_sync(session_manager_.connection_, bus_name_.c_str(),
+                                                      object_path_.c_str(), object_manager::INTERFACE_NAME,
+                                                      "GetManagedObjects", nullptr,
+                                                      G_VARIANT_TYPE("(a{oa{sa{sv}}})"), G_DBUS_CALL_FLAGS_NONE, -1,
+                                                      nullptr, &error),
+                          g_variant_unref};
+
+    std::string                                          error_message;
+    std::map<object_path_t, interfaces_and_properties_t> objects;
+
+    if (result) {
+        try {
+            objects = extract<std::map<object_path_t, interfaces_and_properties_t>>(result.get(), 0);
+        } catch (const std::exception& e) {
+            error_message = e.what();
+            result.reset();
+        }
+    } else {
+        error_message = error->message;
+        g_error_free(error);
+    }
+
+    mirror::notifications_t notifications;
+
+    {
+        std::lock_guard lock {mirror_->mutex};
+
+        if (result)
+            mirror_->objects = std::move(objects);
+
+        // Whatever came in during the call is at least as recent as the call's result.
+        for (auto&& p : mirror_->pending) {
+            try {
+                mirror_->apply(p.signal_name, p.object_path, p.parameters.get(), notifications);
+            } catch (const std::exception& e) {
+                g_warning("Could not apply signal '%s' from '%s': %s", p.signal_name.c_str(), p.object_path.c_str(),
+                          e.what());
+            }
+        }
+
+        mirror_->pending.clear();
+        mirror_->refreshing = false;
+    }
+
+    for (auto&& notify : notifications)
+        notify();
+
+    if (!result)
+        throw std::runtime_error("Could not load managed objects: " + error_message);
+}
+
+std::vector<object_path_t> object_manager_client::object_paths(const std::string& interface_name) const
+{
+    std::vector<object_path_t> paths;
+    std::lock_guard            lock {mirror_->mutex};
+
+    for (auto&& [path, interfaces] : mirror_->objects)
+        if (interface_name.empty() || interfaces.count(interface_name))
+            paths.push_back(path);
+
+    return paths;
+}
+
+std::vector<std::string> object_manager_client::interface_names(const object_path_t& object_path) const
+{
+    std::vector<std::string> names;
+    std::lock_guard          lock {mirror_->mutex};
+
+    auto it = mirror_->objects.find(object_path);
+
+    if (it != mirror_->objects.end())
+        for (auto&& [interface_name, properties] : it->second)
+            names.push_back(interface_name);
+
+    return names;
+}
+
+bool object_manager_client::has_interface(const object_path_t& object_path, const std::string& interface_name) const
+{
+    std::lock_guard lock {mirror_->mutex};
+
+    auto it = mirror_->objects.find(object_path);
+
+    return it != mirror_->objects.end() && it->second.count(interface_name);
+}
+
+raw_variant object_manager_client::raw_property(const object_path_t& object_path, const std::string& interface_name,
+                                                const std::string& property_name) const
+{
+    std::lock_guard lock {mirror_->mutex};
+
+    auto object_it = mirror_->objects.find(object_path);
+
+    if (object_it != mirror_->objects.end()) {
+        auto interface_it = object_it->second.find(interface_name);
+
+        if (interface_it != object_it->second.end()) {
+            auto property_it = interface_it->second.find(property_name);
+
+            if (property_it != interface_it->second.end())
+                return property_it->second;
+        }
+    }
+
+    throw std::runtime_error("Unknown property '" + interface_name + "." + property_name + "' of '"
+                             + object_path.generic_string() + "'!");
+}
+
+void object_manager_client::interfaces_added_handler(const interfaces_handler_t& handler)
+{
+    std::lock_guard lock {mirror_->mutex};
+    mirror_->interfaces_added_handler = handler;
+}
+
+void object_manager_client::interfaces_removed_handler(const interfaces_handler_t& handler)
+{
+    std::lock_guard lock {mirror_->mutex};
+    mirror_->interfaces_removed_handler = handler;
+}
+
+void object_manager_client::properties_changed_handler(const properties_handler_t& handler)
+{
+    std::lock_guard lock {mirror_->mutex};
+    mirror_->properties_changed_handler = handler;
+}
+
+void object_manager_client::on_signal(GDBusConnection* /* connection */, const gchar* /* sender_name */,
+                                      const gchar* object_path, const gchar* /* interface_name */,
+                                      const gchar* signal_name, GVariant* parameters, gpointer user_data)
+{
+    auto& m = **static_cast<std::shared_ptr<mirror>*>(user_data);
+
+    mirror::notifications_t notifications;
+
+    try {
+        {
+            std::lock_guard lock {m.mutex};
+
+            if (m.refreshing) {
+                m.pending.push_back({signal_name, object_path, {g_variant_ref(parameters), g_variant_unref}});
+                return;
+            }
+
+            m.apply(signal_name, object_path, parameters, notifications);
+        }
+
+        for (auto&& notify : notifications)
+            notify();
+
+    } catch (const std::exception& e) {
+        g_warning("Could not apply signal '%s' from '%s': %s", signal_name, object_path, e.what());
+    }
+}
+
+void object_manager_client::free_mirror_ref(gpointer user_data)
+{
+    delete static_cast<std::shared_ptr<mirror>*>(user_data);
+}
+
+} // end of namespace easydbuspp
@@ -0,0 +1,117 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include <peer_server.h>
+#include <stdexcept>
+
+namespace easydbuspp {
+
+peer_server::peer_server(const std::string& address, const peer_handler_t& peer_handler, dispatch_t dispatch)
+    : peer_handler_ {peer_handler}, dispatch_ {dispatch}
+{
+    GError* error {nullptr};
+    gchar*  guid = g_dbus_generate_guid();
+
+    server_ = g_dbus_server_new_sync(address.c_str(), G_DBUS_SERVER_FLAGS_AUTHENTICATION_REQUIRE_SAME_USER, guid,
+                                     nullptr, nullptr, &error);
+    g_free(guid);
+
+    if (!server_) {
+        std::string error_message = error->message;
+        g_error_free(error);
+
+        throw std::runtime_error("Could not listen on '" + address + "': " + error_message);
+    }
+
+    new_connection_handler_id_ = g_signal_connect(server_, "new-connection", G_CALLBACK(on_new_connection), this);
+    g_dbus_server_start(server_);
+}
+
+peer_server::~peer_server()
+{
+    g_signal_handler_disconnect(server_, new_connection_handler_id_);
+    g_dbus_server_stop(server_);
+
+    std::map<GDBusConnection*, peer> peers;
+
+    {
+        std::lock_guard lock {peers_mutex_};
+        peers.swap(peers_);
+    }
+
+    for (auto&& [connection, p] : peers)
+        disconnect(connection, p);
+
+    g_object_unref(server_);
+}
+
+peer_address_t peer_server::client_address() const
+{
+    return {g_dbus_server_get_client_address(server_)};
+}
+
+size_t peer_server::peer_count() const
+{
+    std::lock_guard lock {peers_mutex_};
+
+    return peers_.size();
+}
+
+gboolean peer_server::on_new_connection(GDBusServer* /* server */, GDBusConnection* connection, gpointer user_data)
+{
+    peer_server* server = static_cast<peer_server*>(user_data);
+
+    try {
+        peer p;
+
+        // The constructor is private (and friends with us), so no std::make_unique().
+        p.session.reset(new session_manager {connection, server->dispatch_});
+
+        if (server->peer_handler_)
+            p.state = server->peer_handler_(*p.session);
+
+        // Emitted on this same thread, so it can't have happened yet.
+        p.closed_handler_id = g_signal_connect(connection, "closed", G_CALLBACK(on_connection_closed), server);
+
+        std::lock_guard lock {server->peers_mutex_};
+        server->peers_.emplace(connection, std::move(p));
+
+    } catch (const std::exception& e) {
+        g_warning("Rejecting peer connection: %s", e.what());
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+void peer_server::on_connection_closed(GDBusConnection* connection, gboolean /* remote_peer_vanished */,
+                                       GError* /* error */, gpointer user_data)
+{
+    peer_server* server = static_cast<peer_server*>(user_data);
+    peer         p;
+
+    {
+        std::lock_guard lock {server->peers_mutex_};
+
+        auto it = server->peers_.find(connection);
+
+        if (it == server->peers_.end())
+            return;
+
+        p = std::move(it->second);
+        server->peers_.erase(it);
+    }
+
+    disconnect(connection, p);
+}
+
+void peer_server::disconnect(GDBusConnection* connection, peer& p)
+{
+    g_signal_handler_disconnect(connection, p.closed_handler_id);
+
+    p.state.reset();
+    p.session.reset();
+}
+
+} // end of namespace easydbuspp
@@ -17,9 +17,15 @@ proxy::proxy(session_manager& session_mgr, const std::string& bus_name, const st
     if (!session_manager_.connection_)
         throw std::runtime_error("Could not create proxy: no live D-Bus connection!");
 
-    proxy_ = g_dbus_proxy_new_sync(session_manager_.connection_, G_DBUS_PROXY_FLAGS_NONE,
-                                   nullptr /* GDBusInterfaceInfo */, bus_name.c_str(),
-                                   object_path.generic_string().c_str(), interface_name.c_str(), nullptr, &error);
+    // Peer-to-peer connections have no bus, so there's no bus name to address the object by.
+    const gchar* name = g_dbus_connection_get_unique_name(session_manager_.connection_) ? bus_name.c_str() : nullptr;
+
+    // The proxy's signals and property updates get dispatched on the session_manager's thread.
+    proxy_ = session_manager_.run_in_context([&] {
+        return g_dbus_proxy_new_sync(session_manager_.connection_, G_DBUS_PROXY_FLAGS_NONE,
+                                     nullptr /* GDBusInterfaceInfo */, name, object_path.generic_string().c_str(),
+                                     interface_name.c_str(), nullptr, &error);
+    });
 
     if (!proxy_) {
         std::string error_message = error->message;
@@ -36,7 +42,9 @@ proxy::~proxy()
 
 std::string proxy::unique_bus_name() const
 {
-    return g_dbus_connection_get_unique_name(g_dbus_proxy_get_connection(proxy_));
+    const gchar* unique_name = g_dbus_connection_get_unique_name(g_dbus_proxy_get_connection(proxy_));
+
+    return unique_name ? unique_name : "";
 }
 
 } // end of namespace easydbuspp
@@ -0,0 +1,54 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include <array>
+#include <cstddef>
+#include <request_arena.h>
+
+namespace easydbuspp {
+
+namespace {
+
+struct thread_arena {
+    // Most requests fit in the initial buffer, which release() rewinds to, so the upstream
+    // (heap) resource is only touched for unusually large ones.
+    static constexpr size_t INITIAL_SIZE = 64 * 1024;
+
+    alignas(std::max_align_t) std::array<std::byte, INITIAL_SIZE> initial_buffer_;
+    std::pmr::monotonic_buffer_resource resource_ {initial_buffer_.data(), initial_buffer_.size()};
+    unsigned                            depth_ {0};
+};
+
+thread_arena& current_thread_arena()
+{
+    thread_local thread_arena arena;
+    return arena;
+}
+
+} // end of anonymous namespace
+
+std::pmr::memory_resource* request_memory_resource()
+{
+    thread_arena& arena = current_thread_arena();
+
+    if (arena.depth_ == 0)
+        return std::pmr::get_default_resource();
+
+    return &arena.resource_;
+}
+
+request_arena_scope::request_arena_scope()
+{
+    ++current_thread_arena().depth_;
+}
+
+request_arena_scope::~request_arena_scope()
+{
+    thread_arena& arena = current_thread_arena();
+
+    if (--arena.depth_ == 0)
+        arena.resource_.release();
+}
+
+} // end of namespace easydbuspp
@@ -3,66 +3,292 @@
 // SPDX-License-Identifier: AGPL-3.0-only
 
 #include <object.h>
+#include <object_manager.h>
 #include <session_manager.h>
 
 namespace easydbuspp {
 
-session_manager::session_manager(bus_type_t bus_type)
+session_manager::session_manager(bus_type_t bus_type, dispatch_t dispatch, connection_t connection)
+    : connection_ {open_connection(bus_type, connection)}, private_connection_ {connection == connection_t::PRIVATE}
 {
-    GError* error {nullptr};
+    if (dispatch == dispatch_t::OWN_THREAD) {
+        context_ = g_main_context_new();
+        start_dispatch_thread();
+    }
+}
 
-    connection_ = g_bus_get_sync(to_g_bus_type(bus_type), nullptr, &error);
+session_manager::session_manager(bus_type_t bus_type, const std::string& bus_name, dispatch_t dispatch,
+                                 connection_t connection)
+    : bus_name_ {bus_name}, private_connection_ {connection == connection_t::PRIVATE}
+{
+    // A private connection is there right away, so there's no bus to acquire, only the name.
+    if (private_connection_)
+        connection_ = open_connection(bus_type, connection);
 
-    if (!connection_) {
-        std::string error_message = error->message;
-        g_error_free(error);
+    if (dispatch == dispatch_t::OWN_THREAD) {
+        context_ = g_main_context_new();
 
-        throw std::runtime_error("Can't connect to the bus: " + error_message);
+        // The name ownership callbacks (and so the registrations on_bus_acquired() makes) will be dispatched
+        // on the context that is the thread-default one at this point.
+        g_main_context_push_thread_default(context_);
+    }
+
+    auto flags
+        = static_cast<GBusNameOwnerFlags>(G_BUS_NAME_OWNER_FLAGS_ALLOW_REPLACEMENT | G_BUS_NAME_OWNER_FLAGS_REPLACE);
+
+    if (private_connection_)
+        owner_id_ = g_bus_own_name_on_connection(connection_, bus_name.c_str(), flags, on_name_acquired,
+                                                 on_name_lost, this, nullptr);
+    else
+        owner_id_ = g_bus_own_name(to_g_bus_type(bus_type), bus_name.c_str(), flags, on_bus_acquired,
+                                   on_name_acquired, on_name_lost, this, nullptr);
+
+    if (context_) {
+        g_main_context_pop_thread_default(context_);
+        start_dispatch_thread();
     }
 }
 
-session_manager::session_manager(bus_type_t bus_type, const std::string& bus_name) : bus_name_ {bus_name}
+session_manager::session_manager(const peer_address_t& peer, dispatch_t dispatch)
+    : connection_ {open_connection(peer.address, G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT)},
+      private_connection_ {true}
 {
-    owner_id_ = g_bus_own_name(
-        to_g_bus_type(bus_type), bus_name.c_str(),
-        static_cast<GBusNameOwnerFlags>(G_BUS_NAME_OWNER_FLAGS_ALLOW_REPLACEMENT | G_BUS_NAME_OWNER_FLAGS_REPLACE),
-        on_bus_acquired, on_name_acquired, on_name_lost, this, nullptr);
+    if (dispatch == dispatch_t::OWN_THREAD) {
+        context_ = g_main_context_new();
+        start_dispatch_thread();
+    }
+}
+
+session_manager::session_manager(GDBusConnection* connection, dispatch_t dispatch)
+    : connection_ {static_cast<GDBusConnection*>(g_object_ref(connection))}, private_connection_ {true}
+{
+    if (dispatch == dispatch_t::OWN_THREAD) {
+        context_ = g_main_context_new();
+        start_dispatch_thread();
+    }
 }
 
 session_manager::~session_manager()
 {
     if (connection_) {
+        std::lock_guard lock {objects_mutex_};
+
         for (auto&& object_ptr : objects_)
             object_ptr->disconnect();
     }
 
+    // Outstanding signal_subscription handles can't reach the table anymore after this.
+    signal_table_.reset();
+
     if (owner_id_ != 0)
         g_bus_unown_name(owner_id_);
 
+    stop_dispatch_thread();
+
+    if (private_connection_)
+        g_dbus_connection_close_sync(connection_, nullptr, nullptr);
+
     if (connection_)
         g_object_unref(connection_);
 }
 
+std::string session_manager::unique_bus_name() const
+{
+    if (!connection_)
+        throw std::runtime_error("No unique bus name: no live D-Bus connection!");
+
+    const gchar* unique_name = g_dbus_connection_get_unique_name(connection_);
+
+    return unique_name ? unique_name : "";
+}
+
 void session_manager::attach(object* object_ptr)
 {
     if (!object_ptr)
         throw std::runtime_error("Won't register a nullptr object!");
 
-    objects_.insert(object_ptr);
+    {
+        std::lock_guard lock {objects_mutex_};
+
+        objects_.insert(object_ptr);
+
+        // If there's no connection yet, on_bus_acquired() will connect the object.
+        if (!connection_)
+            return;
+    }
+
+    // Registered (and announced) from the dispatch context, along with whatever the object adds right after.
+    object_ptr->schedule_registration();
 }
 
 void session_manager::detach(object* object_ptr)
 {
-    if (object_ptr) {
-        object_ptr->disconnect();
+    if (!object_ptr)
+        return;
+
+    {
+        std::unique_lock lock {objects_mutex_};
         objects_.erase(object_ptr);
+        wait_until_unused(lock, object_ptr);
+    }
+
+    bool announce = object_ptr->registered() && !object_ptr->lookup_child_;
+
+    object_ptr->disconnect();
+
+    if (announce)
+        interfaces_removed(*object_ptr, object_ptr->interface_names());
+}
+
+void session_manager::attach(object_manager* manager_ptr)
+{
+    std::lock_guard lock {objects_mutex_};
+
+    object_managers_.insert(manager_ptr);
+}
+
+void session_manager::detach(object_manager* manager_ptr)
+{
+    std::unique_lock lock {objects_mutex_};
+
+    object_managers_.erase(manager_ptr);
+    wait_until_unused(lock, manager_ptr);
+}
+
+void session_manager::interfaces_added(const object&                                                   obj,
+                                       const std::vector<std::shared_ptr<const interface_definition>>& definitions)
+{
+    std::vector<object_manager*> managers;
+
+    {
+        std::lock_guard lock {objects_mutex_};
+        managers.assign(object_managers_.begin(), object_managers_.end());
     }
+
+    // The announcement reads properties, so it runs user code.
+    for_each_attached(managers, object_managers_, [&obj, &definitions](object_manager& manager) {
+        manager.interfaces_added(obj, definitions);
+    });
+}
+
+void session_manager::interfaces_removed(const object& obj, const std::vector<std::string>& interface_names)
+{
+    std::vector<object_manager*> managers;
+
+    {
+        std::lock_guard lock {objects_mutex_};
+        managers.assign(object_managers_.begin(), object_managers_.end());
+    }
+
+    for_each_attached(managers, object_managers_, [&obj, &interface_names](object_manager& manager) {
+        manager.interfaces_removed(obj, interface_names);
+    });
+}
+
+void session_manager::wait_until_unused(std::unique_lock<std::mutex>& lock, const void* ptr)
+{
+    in_use_cv_.wait(lock, [this, ptr] {
+        return in_use_.count(ptr) == 0;
+    });
+}
+
+GDBusConnection* session_manager::open_connection(bus_type_t bus_type, connection_t connection)
+{
+    GError*          error {nullptr};
+    GDBusConnection* result {nullptr};
+
+    if (connection == connection_t::SHARED) {
+        result = g_bus_get_sync(to_g_bus_type(bus_type), nullptr, &error);
+    } else {
+        gchar* address = g_dbus_address_get_for_bus_sync(to_g_bus_type(bus_type), nullptr, &error);
+
+        if (address) {
+            std::string bus_address {address};
+            g_free(address);
+
+            return open_connection(bus_address,
+                                   static_cast<GDBusConnectionFlags>(G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT
+                                                                     | G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION));
+        }
+    }
+
+    if (!result) {
+        std::string error_message = error->message;
+        g_error_free(error);
+
+        throw std::runtime_error("Can't connect to the bus: " + error_message);
+    }
+
+    return result;
+}
+
+GDBusConnection* session_manager::open_connection(const std::string& address, GDBusConnectionFlags flags)
+{
+    GError*          error {nullptr};
+    GDBusConnection* result = g_dbus_connection_new_for_address_sync(address.c_str(), flags, nullptr, nullptr, &error);
+
+    if (!result) {
+        std::string error_message = error->message;
+        g_error_free(error);
+
+        throw std::runtime_error("Can't connect to '" + address + "': " + error_message);
+    }
+
+    return result;
+}
+
+void session_manager::start_dispatch_thread()
+{
+    context_loop_ = g_main_loop_new(context_, FALSE);
+
+    dispatch_thread_ = std::thread {[this] {
+        g_main_context_push_thread_default(context_);
+        g_main_loop_run(context_loop_);
+        g_main_context_pop_thread_default(context_);
+    }};
+}
+
+void session_manager::stop_dispatch_thread()
+{
+    if (!context_)
+        return;
+
+    // Quitting from inside the loop works even if it hasn't started running yet.
+    g_main_context_invoke(
+        context_,
+        [](gpointer loop) -> gboolean {
+            g_main_loop_quit(static_cast<GMainLoop*>(loop));
+            return G_SOURCE_REMOVE;
+        },
+        context_loop_);
+
+    dispatch_thread_.join();
+
+    // Run whatever is still pending (e.g. the destroy notifications of signal subscriptions).
+    while (g_main_context_iteration(context_, FALSE)) { }
+
+    g_main_loop_unref(context_loop_);
+    g_main_context_unref(context_);
+}
+
+gboolean session_manager::run_task(gpointer data)
+{
+    (*static_cast<std::function<void()>*>(data))();
+    return G_SOURCE_REMOVE;
+}
+
+void session_manager::free_task(gpointer data)
+{
+    delete static_cast<std::function<void()>*>(data);
 }
 
 void session_manager::on_bus_acquired(GDBusConnection* connection, const gchar* /* name */, gpointer user_data)
 {
     session_manager* manager = static_cast<session_manager*>(user_data);
-    manager->connection_     = connection;
+    std::lock_guard  lock {manager->objects_mutex_};
+
+    // Released in the destructor.
+    manager->connection_ = static_cast<GDBusConnection*>(g_object_ref(connection));
 
     for (auto&& obj_ptr : manager->objects_)
         obj_ptr->connect();
@@ -81,19 +307,4 @@ void session_manager::on_name_lost(GDBusConnection* connection, const gchar* /*
     throw std::runtime_error("Lost D-Bus name (is another application that owns it already running?)");
 }
 
-void session_manager::on_signal(GDBusConnection* /* connection */, const gchar* /* sender_name */,
-                                const gchar* /* object_path */, const gchar* /* interface_name */,
-                                const gchar* signal_name, GVariant* parameters, gpointer user_data)
-{
-    using namespace std::string_literals;
-
-    session_manager* manager = static_cast<session_manager*>(user_data);
-    auto             it      = manager->signal_handlers_.find(signal_name);
-
-    if (it == manager->signal_handlers_.end())
-        throw std::runtime_error("No signal handler registered for '"s + signal_name + "''!");
-
-    it->second(parameters);
-}
-
 } // end of namespace easydbuspp
@@ -0,0 +1,71 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include <cstdint>
+#include <session_shards.h>
+#include <stdexcept>
+#include <string>
+
+namespace easydbuspp {
+
+session_shards::session_shards(bus_type_t bus_type, size_t count, dispatch_t dispatch)
+{
+    if (count == 0)
+        throw std::runtime_error("Can't create zero session shards!");
+
+    for (size_t i = 0; i < count; ++i)
+        shards_.push_back(std::make_unique<session_manager>(bus_type, dispatch, connection_t::PRIVATE));
+}
+
+session_shards::session_shards(bus_type_t bus_type, const std::vector<std::string>& bus_names, dispatch_t dispatch)
+{
+    if (bus_names.empty())
+        throw std::runtime_error("Can't create zero session shards!");
+
+    for (auto&& bus_name : bus_names) {
+        if (bus_name.empty())
+            shards_.push_back(std::make_unique<session_manager>(bus_type, dispatch, connection_t::PRIVATE));
+        else
+            shards_.push_back(
+                std::make_unique<session_manager>(bus_type, bus_name, dispatch, connection_t::PRIVATE));
+    }
+}
+
+size_t session_shards::size() const
+{
+    return shards_.size();
+}
+
+session_manager& session_shards::operator[](size_t index)
+{
+    if (index >= shards_.size())
+        throw std::runtime_error("Session shard index " + std::to_string(index) + " out of range!");
+
+    return *shards_[index];
+}
+
+size_t session_shards::index_for(const object_path_t& object_path) const
+{
+    // 64-bit FNV-1a: unlike std::hash, other processes (and other standard libraries) agree on it.
+    uint64_t hash {14695981039346656037ULL};
+
+    for (unsigned char c : object_path.generic_string()) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+
+    return hash % shards_.size();
+}
+
+session_manager& session_shards::for_path(const object_path_t& object_path)
+{
+    return *shards_[index_for(object_path)];
+}
+
+session_manager& session_shards::next()
+{
+    return *shards_[next_++ % shards_.size()];
+}
+
+} // end of namespace easydbuspp
@@ -0,0 +1,218 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <shared_buffer.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace easydbuspp {
+
+namespace {
+
+constexpr int REQUIRED_SEALS = F_SEAL_WRITE | F_SEAL_GROW | F_SEAL_SHRINK;
+
+std::runtime_error errno_error(const std::string& what)
+{
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+// Closes the fd on the way out, unless it's been released (to a region).
+class fd_guard {
+
+public:
+    explicit fd_guard(int fd) : fd_ {fd} { }
+
+    ~fd_guard()
+    {
+        if (fd_ >= 0)
+            close(fd_);
+    }
+
+    fd_guard(const fd_guard&)            = delete;
+    fd_guard& operator=(const fd_guard&) = delete;
+
+    int get() const { return fd_; }
+
+    void release() { fd_ = -1; }
+
+private:
+    int fd_;
+};
+
+} // end of anonymous namespace
+
+struct shared_buffer::region {
+    // Inline bytes, no memfd.
+    explicit region(std::vector<std::byte> bytes) : fd_ {-1}, size_ {bytes.size()}, bytes_ {std::move(bytes)} { }
+
+    // Only owns `fd` once constructed, so the caller closes it if this throws.
+    region(int fd, size_t size) : fd_ {fd}, size_ {size}
+    {
+        if (size_ == 0)
+            return;
+
+        addr_ = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+
+        if (addr_ == MAP_FAILED)
+            throw errno_error("Could not map shared buffer");
+    }
+
+    ~region()
+    {
+        if (addr_ != MAP_FAILED)
+            munmap(addr_, size_);
+
+        if (fd_ >= 0)
+            close(fd_);
+    }
+
+    region(const region&)            = delete;
+    region& operator=(const region&) = delete;
+
+    int                    fd_;
+    size_t                 size_;
+    void*                  addr_ {MAP_FAILED};
+    std::vector<std::byte> bytes_;
+};
+
+shared_buffer::shared_buffer(const void* data, size_t size, size_t inline_threshold)
+{
+    if (size <= inline_threshold) {
+        const std::byte* bytes = static_cast<const std::byte*>(data);
+        region_                = std::make_shared<region>(std::vector<std::byte>(bytes, bytes + size));
+        return;
+    }
+
+    fd_guard fd {memfd_create("easydbuspp-shared-buffer", MFD_CLOEXEC | MFD_ALLOW_SEALING)};
+
+    if (fd.get() < 0)
+        throw errno_error("Could not create shared buffer memfd");
+
+    if (ftruncate(fd.get(), size) < 0)
+        throw errno_error("Could not size shared buffer");
+
+    const char* src       = static_cast<const char*>(data);
+    size_t      remaining = size;
+
+    while (remaining > 0) {
+        ssize_t written = pwrite(fd.get(), src + (size - remaining), remaining, size - remaining);
+
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+
+            throw errno_error("Could not fill shared buffer");
+        }
+
+        remaining -= written;
+    }
+
+    if (fcntl(fd.get(), F_ADD_SEALS, REQUIRED_SEALS | F_SEAL_SEAL) < 0)
+        throw errno_error("Could not seal shared buffer");
+
+    region_ = std::make_shared<region>(fd.get(), size);
+    fd.release();
+}
+
+shared_buffer::shared_buffer(const std::vector<std::byte>& bytes, size_t inline_threshold)
+    : shared_buffer(bytes.data(), bytes.size(), inline_threshold)
+{
+}
+
+const std::byte* shared_buffer::data() const
+{
+    if (!region_ || region_->size_ == 0)
+        return nullptr;
+
+    if (region_->fd_ < 0)
+        return region_->bytes_.data();
+
+    return static_cast<const std::byte*>(region_->addr_);
+}
+
+size_t shared_buffer::size() const
+{
+    return region_ ? region_->size_ : 0;
+}
+
+bool shared_buffer::inline_bytes() const
+{
+    return !region_ || region_->fd_ < 0;
+}
+
+int shared_buffer::fd() const
+{
+    if (inline_bytes())
+        throw std::runtime_error("Inline shared_buffer has no fd!");
+
+    return region_->fd_;
+}
+
+GVariant* shared_buffer::encode() const
+{
+    if (!inline_bytes()) {
+        if (fd_index_ < 0)
+            throw std::runtime_error("A memfd-backed shared_buffer can only be a method parameter or return value!");
+
+        return g_variant_new_variant(g_variant_new_handle(fd_index_));
+    }
+
+    static const std::byte none {};
+
+    return g_variant_new_variant(
+        g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, empty() ? &none : data(), size(), sizeof(std::byte)));
+}
+
+shared_buffer shared_buffer::decode(GVariant* v)
+{
+    g_variant_ptr inner {g_variant_get_variant(v), g_variant_unref};
+
+    shared_buffer ret;
+
+    if (g_variant_is_of_type(inner.get(), G_VARIANT_TYPE_HANDLE)) {
+        // Only the fd index for now, set_up_from_g_unix_fd_list() takes over the actual fd.
+        ret.fd_index_ = g_variant_get_handle(inner.get());
+        return ret;
+    }
+
+    if (!g_variant_is_of_type(inner.get(), G_VARIANT_TYPE_BYTESTRING))
+        throw std::runtime_error("Unknown shared_buffer encoding!");
+
+    gsize            size {0};
+    const std::byte* bytes
+        = static_cast<const std::byte*>(g_variant_get_fixed_array(inner.get(), &size, sizeof(std::byte)));
+
+    ret.region_ = std::make_shared<region>(std::vector<std::byte>(bytes, bytes + size));
+
+    return ret;
+}
+
+shared_buffer shared_buffer::adopt(int fd)
+{
+    fd_guard guard {fd};
+
+    int seals = fcntl(fd, F_GET_SEALS);
+
+    if (seals < 0 || (seals & REQUIRED_SEALS) != REQUIRED_SEALS)
+        throw std::runtime_error("Received shared buffer fd is not a sealed memfd!");
+
+    struct stat st {};
+
+    if (fstat(fd, &st) < 0)
+        throw errno_error("Could not query shared buffer size");
+
+    shared_buffer ret;
+    ret.region_ = std::make_shared<region>(fd, static_cast<size_t>(st.st_size));
+    guard.release();
+
+    return ret;
+}
+
+} // end of namespace easydbuspp
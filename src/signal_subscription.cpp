@@ -0,0 +1,48 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include <signal_subscription.h>
+#include <signal_table.h>
+
+namespace easydbuspp {
+
+signal_subscription::~signal_subscription()
+{
+    unsubscribe();
+}
+
+signal_subscription::signal_subscription(signal_subscription&& other) noexcept
+    : table_ {std::move(other.table_)}, id_ {other.id_}
+{
+    other.id_ = 0;
+}
+
+signal_subscription& signal_subscription::operator=(signal_subscription&& other) noexcept
+{
+    if (this != &other) {
+        unsubscribe();
+
+        table_    = std::move(other.table_);
+        id_       = other.id_;
+        other.id_ = 0;
+    }
+
+    return *this;
+}
+
+void signal_subscription::unsubscribe()
+{
+    if (auto table = table_.lock())
+        table->remove(id_);
+
+    detach();
+}
+
+void signal_subscription::detach()
+{
+    table_.reset();
+    id_ = 0;
+}
+
+} // end of namespace easydbuspp
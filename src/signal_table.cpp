@@ -0,0 +1,381 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <signal_table.h>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace easydbuspp {
+
+g_thread_pool signal_table::thread_pool_ {g_thread_pool_function};
+
+// The handler of a subscriber, plus (for THREAD_POOL, STRAND and QUEUE) the signals it has yet to handle. Pool
+// tasks and QUEUE consumer threads hold on to it, so it may outlive the subscriber (it is closed then).
+struct signal_table::delivery_queue {
+    delivery_queue(handler_t queue_handler, size_t queue_capacity)
+        : handler {std::move(queue_handler)}, capacity {queue_capacity}
+    {
+    }
+
+    // INLINE and THREAD_POOL: handles a single signal, unless the queue is closed.
+    void invoke(GVariant* parameters)
+    {
+        {
+            std::lock_guard lock {mutex};
+
+            if (closed)
+                return;
+
+            ++in_flight;
+        }
+
+        run(parameters);
+    }
+
+    // STRAND: handles pending signals in order, until there are none left.
+    void drain()
+    {
+        for (;;) {
+            g_variant_ptr parameters {nullptr, g_variant_unref};
+
+            {
+                std::lock_guard lock {mutex};
+
+                if (closed || pending.empty()) {
+                    scheduled = false;
+                    return;
+                }
+
+                parameters = std::move(pending.front());
+                pending.pop_front();
+                ++in_flight;
+            }
+
+            run(parameters.get());
+        }
+    }
+
+    // QUEUE: the consumer thread.
+    void consume()
+    {
+        for (;;) {
+            g_variant_ptr parameters {nullptr, g_variant_unref};
+
+            {
+                std::unique_lock lock {mutex};
+                cv.wait(lock, [this] {
+                    return closed || !pending.empty();
+                });
+
+                if (closed)
+                    return;
+
+                parameters = std::move(pending.front());
+                pending.pop_front();
+                ++in_flight;
+            }
+
+            run(parameters.get());
+        }
+    }
+
+    // Stops the deliveries, drops the pending signals, and waits for the handler calls that are running to
+    // return. Unless it's one of them doing the closing: it would wait for itself.
+    void close()
+    {
+        std::unique_lock lock {mutex};
+
+        closed = true;
+        pending.clear();
+        cv.notify_one();
+
+        if (current == this)
+            return;
+
+        idle_cv.wait(lock, [this] {
+            return in_flight == 0;
+        });
+    }
+
+    // Calls the handler for a signal counted in in_flight. There's no caller to report errors to here.
+    void run(GVariant* parameters)
+    {
+        const delivery_queue* previous = current;
+        current                        = this;
+
+        try {
+            handler(parameters);
+        } catch (const std::exception& e) {
+            g_warning("Signal handler error: %s", e.what());
+        }
+
+        current = previous;
+
+        std::lock_guard lock {mutex};
+
+        if (--in_flight == 0)
+            idle_cv.notify_all();
+    }
+
+    const handler_t           handler;
+    const size_t              capacity;
+    std::mutex                mutex;
+    std::condition_variable   cv;      // QUEUE: signals the consumer thread.
+    std::condition_variable   idle_cv; // Signals close() that in_flight has dropped to 0.
+    std::deque<g_variant_ptr> pending;
+    size_t                    in_flight {0};
+    bool                      scheduled {false}; // STRAND: a drain() task is queued or running.
+    bool                      closed {false};
+
+    // The queue whose handler this thread is running, if any.
+    static inline thread_local const delivery_queue* current {nullptr};
+};
+
+struct signal_table::subscriber {
+    subscriber(uint64_t subscriber_id, handler_t subscriber_handler, const signal_delivery& delivery)
+        : id {subscriber_id}, mode {delivery.mode}
+    {
+        if (mode == signal_delivery_t::QUEUE && delivery.queue_capacity == 0)
+            throw std::runtime_error("Signal delivery queues need room for at least one signal!");
+
+        queue = std::make_shared<delivery_queue>(std::move(subscriber_handler), delivery.queue_capacity);
+
+        if (mode == signal_delivery_t::QUEUE)
+            consumer = std::thread {&delivery_queue::consume, queue};
+    }
+
+    ~subscriber() { close(); }
+
+    subscriber(const subscriber&)            = delete;
+    subscriber& operator=(const subscriber&) = delete;
+
+    // Once this returns, the handler is neither running nor going to run again (see delivery_queue::close()).
+    void close()
+    {
+        queue->close();
+
+        if (!consumer.joinable())
+            return;
+
+        // A QUEUE handler unsubscribing itself: its thread exits once the handler returns.
+        if (consumer.get_id() == std::this_thread::get_id())
+            consumer.detach();
+        else
+            consumer.join();
+    }
+
+    // Called on the D-Bus dispatch thread: only INLINE subscribers do any actual work here.
+    void deliver(GVariant* parameters) const
+    {
+        switch (mode) {
+        case signal_delivery_t::INLINE:
+            queue->invoke(parameters);
+            break;
+
+        case signal_delivery_t::THREAD_POOL:
+            thread_pool_.push(new std::function<void()> {[queue = queue, parameters = g_variant_ref(parameters)] {
+                g_variant_ptr parameters_raii_holder {parameters, g_variant_unref};
+                queue->invoke(parameters);
+            }});
+            break;
+
+        case signal_delivery_t::STRAND: {
+            std::lock_guard lock {queue->mutex};
+
+            if (queue->closed)
+                return;
+
+            queue->pending.emplace_back(g_variant_ref(parameters), g_variant_unref);
+
+            if (!queue->scheduled) {
+                queue->scheduled = true;
+                thread_pool_.push(new std::function<void()> {[queue = queue] {
+                    queue->drain();
+                }});
+            }
+            break;
+        }
+
+        case signal_delivery_t::QUEUE: {
+            std::lock_guard lock {queue->mutex};
+
+            if (queue->closed)
+                return;
+
+            // Better to lose the oldest signal than to stall the dispatch thread.
+            if (queue->pending.size() == queue->capacity)
+                queue->pending.pop_front();
+
+            queue->pending.emplace_back(g_variant_ref(parameters), g_variant_unref);
+            queue->cv.notify_one();
+            break;
+        }
+        }
+    }
+
+    const uint64_t                  id;
+    const signal_delivery_t         mode;
+    std::shared_ptr<delivery_queue> queue;
+    std::thread                     consumer; // QUEUE only.
+};
+
+struct signal_table::route {
+    using subscribers_t = std::vector<std::shared_ptr<subscriber>>;
+
+    signal_key                           key;
+    GDBusConnection*                     connection {nullptr};
+    guint                                subscription_id {0};
+    std::mutex                           mutex;
+    std::shared_ptr<const subscribers_t> subscribers {std::make_shared<const subscribers_t>()};
+};
+
+size_t signal_key_hash::operator()(const signal_key& key) const
+{
+    std::hash<std::string> hasher;
+    size_t                 seed {0};
+
+    for (auto&& field : {&key.sender, &key.interface_name, &key.object_path, &key.signal_name})
+        seed ^= hasher(*field) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+
+    return seed;
+}
+
+signal_table::~signal_table()
+{
+    for (auto&& [key, r] : routes_)
+        close_route(r);
+}
+
+uint64_t signal_table::add(GDBusConnection* connection, const signal_key& key, handler_t handler,
+                           const signal_delivery& delivery)
+{
+    if (!connection)
+        throw std::runtime_error("Can't subscribe to signal '" + key.signal_name + "': no live D-Bus connection!");
+
+    std::lock_guard lock {mutex_};
+
+    auto id             = next_id_++;
+    auto new_subscriber = std::make_shared<subscriber>(id, std::move(handler), delivery);
+    auto it             = routes_.find(key);
+
+    if (it == routes_.end()) {
+        auto* r       = new route;
+        r->key        = key;
+        r->connection = static_cast<GDBusConnection*>(g_object_ref(connection));
+
+        auto nullable = [](const std::string& s) {
+            return s.empty() ? nullptr : s.c_str();
+        };
+
+        r->subscription_id = g_dbus_connection_signal_subscribe(
+            connection, nullable(key.sender), nullable(key.interface_name), nullable(key.signal_name),
+            nullable(key.object_path), nullptr, G_DBUS_SIGNAL_FLAGS_NONE, on_signal, r, free_route);
+
+        it = routes_.emplace(key, r).first;
+    }
+
+    route* r = it->second;
+
+    {
+        std::lock_guard route_lock {r->mutex};
+
+        auto subscribers = std::make_shared<route::subscribers_t>(*r->subscribers);
+        subscribers->push_back(std::move(new_subscriber));
+        r->subscribers = std::move(subscribers);
+    }
+
+    subscriber_routes_[id] = r;
+
+    return id;
+}
+
+void signal_table::remove(uint64_t id)
+{
+    std::shared_ptr<subscriber> removed;
+
+    {
+        std::lock_guard lock {mutex_};
+
+        auto it = subscriber_routes_.find(id);
+
+        if (it == subscriber_routes_.end())
+            return;
+
+        route* r = it->second;
+        subscriber_routes_.erase(it);
+
+        bool route_empty {false};
+
+        {
+            std::lock_guard route_lock {r->mutex};
+
+            auto subscribers = std::make_shared<route::subscribers_t>(*r->subscribers);
+            auto s_it        = std::find_if(subscribers->begin(), subscribers->end(), [id](auto&& s) {
+                return s->id == id;
+            });
+
+            if (s_it != subscribers->end()) {
+                removed = *s_it;
+                subscribers->erase(s_it);
+            }
+
+            route_empty    = subscribers->empty();
+            r->subscribers = std::move(subscribers);
+        }
+
+        if (route_empty) {
+            routes_.erase(r->key);
+            close_route(r);
+        }
+    }
+
+    // Without the lock: the handler calls being waited for may (un)subscribe, too.
+    if (removed)
+        removed->close();
+}
+
+void signal_table::on_signal(GDBusConnection* /* connection */, const gchar* /* sender_name */,
+                             const gchar* /* object_path */, const gchar* /* interface_name */,
+                             const gchar* /* signal_name */, GVariant* parameters, gpointer user_data)
+{
+    route* r = static_cast<route*>(user_data);
+
+    std::shared_ptr<const route::subscribers_t> subscribers;
+
+    {
+        std::lock_guard route_lock {r->mutex};
+        subscribers = r->subscribers;
+    }
+
+    for (auto&& s : *subscribers)
+        s->deliver(parameters);
+}
+
+void signal_table::g_thread_pool_function(gpointer data, gpointer /* user_data */)
+{
+    using threadpool_fn_t = std::function<void()>;
+
+    std::unique_ptr<threadpool_fn_t> fn_ptr {static_cast<threadpool_fn_t*>(data)};
+    (*fn_ptr)();
+}
+
+void signal_table::close_route(route* r)
+{
+    // GDBus calls free_route() once it's sure that on_signal() won't run for this route again.
+    g_dbus_connection_signal_unsubscribe(r->connection, r->subscription_id);
+}
+
+void signal_table::free_route(gpointer user_data)
+{
+    route* r = static_cast<route*>(user_data);
+
+    g_object_unref(r->connection);
+    delete r;
+}
+
+} // end of namespace easydbuspp
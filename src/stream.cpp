@@ -0,0 +1,230 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <stream.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace easydbuspp {
+
+namespace {
+
+// Records are framed as a native-endian 32-bit length followed by the payload (both ends are on
+// the same host, since the socket is passed as a file descriptor).
+using record_length_t = uint32_t;
+
+std::runtime_error errno_error(const std::string& what)
+{
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+// Returns false on a clean end of stream before the first byte.
+bool read_exactly(int fd, void* buffer, size_t length)
+{
+    char*  dst = static_cast<char*>(buffer);
+    size_t got = 0;
+
+    while (got < length) {
+        ssize_t ret = read(fd, dst + got, length - got);
+
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+
+            throw errno_error("Could not read from stream");
+        }
+
+        if (ret == 0) {
+            if (got == 0)
+                return false;
+
+            throw std::runtime_error("Stream ended in the middle of a record!");
+        }
+
+        got += ret;
+    }
+
+    return true;
+}
+
+void write_exactly(int fd, const void* buffer, size_t length)
+{
+    const char* src  = static_cast<const char*>(buffer);
+    size_t      sent = 0;
+
+    while (sent < length) {
+        // MSG_NOSIGNAL: a reader that went away should be an exception, not a SIGPIPE.
+        ssize_t ret = send(fd, src + sent, length - sent, MSG_NOSIGNAL);
+
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+
+            throw errno_error("Could not write to stream");
+        }
+
+        sent += ret;
+    }
+}
+
+} // end of anonymous namespace
+
+struct stream_reader::state {
+    explicit state(int fd) : fd_ {fd} { }
+    ~state() { ::close(fd_); }
+
+    state(const state&)            = delete;
+    state& operator=(const state&) = delete;
+
+    int                 fd_;
+    std::mutex          read_mutex_;
+    std::atomic<size_t> max_record_size_ {default_max_record_size};
+    bool                failed_ {false}; // Out of sync with the record boundaries.
+};
+
+struct stream_writer::state {
+    explicit state(int fd) : fd_ {fd} { }
+    ~state() { close(); }
+
+    state(const state&)            = delete;
+    state& operator=(const state&) = delete;
+
+    void close()
+    {
+        std::lock_guard lock {write_mutex_};
+
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    int        fd_;
+    std::mutex write_mutex_;
+};
+
+std::pair<stream_reader, stream_writer> make_stream()
+{
+    int fds[2];
+
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0)
+        throw errno_error("Could not create stream socket pair");
+
+    // One-way traffic only.
+    shutdown(fds[0], SHUT_WR);
+    shutdown(fds[1], SHUT_RD);
+
+    return {stream_reader {fds[0]}, stream_writer {fds[1]}};
+}
+
+stream_reader::stream_reader(int fd) : state_ {std::make_shared<state>(fd)}
+{
+}
+
+stream_reader stream_reader::adopt(int fd)
+{
+    return stream_reader {fd};
+}
+
+int stream_reader::fd() const
+{
+    if (!state_)
+        throw std::runtime_error("Can't send an unconnected stream_reader!");
+
+    return state_->fd_;
+}
+
+std::optional<std::string> stream_reader::next()
+{
+    if (!state_)
+        throw std::runtime_error("Can't read from an unconnected stream_reader!");
+
+    std::lock_guard lock {state_->read_mutex_};
+    record_length_t length {0};
+
+    if (state_->failed_)
+        throw std::runtime_error("Can't read from a stream that has had an oversized record!");
+
+    if (!read_exactly(state_->fd_, &length, sizeof(length)))
+        return std::nullopt;
+
+    if (length > state_->max_record_size_) {
+        // The payload is left unread, so what comes next is not the length of a record.
+        state_->failed_ = true;
+
+        throw std::runtime_error("Stream record of " + std::to_string(length) + " bytes exceeds the maximum of "
+                                 + std::to_string(state_->max_record_size_) + " bytes!");
+    }
+
+    std::string record(length, '\0');
+
+    if (length > 0 && !read_exactly(state_->fd_, record.data(), length))
+        throw std::runtime_error("Stream ended in the middle of a record!");
+
+    return record;
+}
+
+void stream_reader::max_record_size(size_t size)
+{
+    if (!state_)
+        throw std::runtime_error("Can't set the maximum record size of an unconnected stream_reader!");
+
+    state_->max_record_size_ = size;
+}
+
+size_t stream_reader::max_record_size() const
+{
+    return state_ ? state_->max_record_size_.load() : default_max_record_size;
+}
+
+stream_writer::stream_writer(int fd) : state_ {std::make_shared<state>(fd)}
+{
+}
+
+stream_writer stream_writer::adopt(int fd)
+{
+    return stream_writer {fd};
+}
+
+int stream_writer::fd() const
+{
+    if (!state_ || state_->fd_ < 0)
+        throw std::runtime_error("Can't send an unconnected or closed stream_writer!");
+
+    return state_->fd_;
+}
+
+void stream_writer::write(const std::string& record)
+{
+    if (!state_)
+        throw std::runtime_error("Can't write to an unconnected stream_writer!");
+
+    if (record.size() > UINT32_MAX)
+        throw std::runtime_error("Stream record too large!");
+
+    std::lock_guard lock {state_->write_mutex_};
+
+    if (state_->fd_ < 0)
+        throw std::runtime_error("Can't write to a closed stream_writer!");
+
+    const record_length_t length = record.size();
+
+    write_exactly(state_->fd_, &length, sizeof(length));
+    write_exactly(state_->fd_, record.data(), record.size());
+}
+
+void stream_writer::close()
+{
+    if (state_)
+        state_->close();
+}
+
+} // end of namespace easydbuspp
@@ -2,6 +2,7 @@
 //
 // SPDX-License-Identifier: AGPL-3.0-only
 
+#include <atomic>
 #include <easydbuspp.h>
 #include <iostream>
 
@@ -28,16 +29,39 @@ int main()
         easydbuspp::session_manager proxy_session_manager {easydbuspp::bus_type_t::SESSION};
         easydbuspp::proxy           proxy {proxy_session_manager, BUS_NAME, INTERFACE_NAME, OBJECT_PATH};
 
-        proxy_session_manager.signal_subscribe(
-            "BroadcastSignal", [&proxy_session_manager](const std::string& s, double d) {
-                std::cout << "Got signal BroadcastSignal: [" << s << "', " << d << "]" << std::endl;
+        std::atomic<int> deliveries {0};
+
+        auto on_broadcast_signal = [&deliveries](const std::string& s, double d) {
+            std::cout << "Got signal BroadcastSignal: [" << s << "', " << d << "]" << std::endl;
+
+            if (++deliveries == 2)
                 easydbuspp::main_loop::instance().stop();
+        };
+
+        // Same signal name, but only one of them filtered by interface and path: neither replaces the other.
+        auto subscription          = proxy_session_manager.signal_subscribe("BroadcastSignal", on_broadcast_signal);
+        auto filtered_subscription = proxy_session_manager.signal_subscribe("BroadcastSignal", on_broadcast_signal, {},
+                                                                             INTERFACE_NAME, OBJECT_PATH);
+
+        std::atomic<bool> unsubscribed_called {false};
+
+        auto unsubscribed = proxy_session_manager.signal_subscribe(
+            "BroadcastSignal", [&unsubscribed_called](const std::string&, double) {
+                unsubscribed_called = true;
             });
 
+        unsubscribed.unsubscribe();
+
         proxy.call<void>("EmitBroadcastSignal");
 
         easydbuspp::main_loop::instance().wait();
 
+        if (deliveries != 2)
+            throw std::runtime_error("BroadcastSignal was not delivered to all subscribers!");
+
+        if (unsubscribed_called)
+            throw std::runtime_error("BroadcastSignal was delivered after unsubscribing!");
+
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << "\n";
         return 1;
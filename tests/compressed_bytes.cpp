@@ -0,0 +1,78 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include <algorithm>
+#include <easydbuspp.h>
+#include <iostream>
+
+int main()
+{
+    try {
+        const std::string               BUS_NAME {"net.test.EasyDBuspp.Test"};
+        const std::string               INTERFACE_NAME {"net.test.EasyDBuspp.TestInterface"};
+        const easydbuspp::object_path_t OBJECT_PATH {"/net/test/EasyDBuspp/TestObject"};
+
+        using wire_format_t = std::tuple<std::byte, std::vector<std::byte>>;
+
+        // Set up an object.
+        easydbuspp::session_manager obj_session_manager {easydbuspp::bus_type_t::SESSION, BUS_NAME};
+        easydbuspp::object          object {obj_session_manager, INTERFACE_NAME, OBJECT_PATH};
+
+        object.add_method("Echo", [](const easydbuspp::compressed_bytes& bytes) {
+            return easydbuspp::compressed_bytes {bytes.bytes()};
+        });
+
+        // Same D-Bus type, but without the decoding: shows what actually went over the bus.
+        object.add_method("WireSize", [](const wire_format_t& wire_format) {
+            return std::tuple {std::get<0>(wire_format), std::get<1>(wire_format).size()};
+        });
+
+        easydbuspp::main_loop::instance().run_async();
+
+        // Set up a proxy to access the object.
+        easydbuspp::session_manager proxy_session_manager {easydbuspp::bus_type_t::SESSION};
+        easydbuspp::proxy           proxy {proxy_session_manager, BUS_NAME, INTERFACE_NAME, OBJECT_PATH};
+
+        std::string log;
+
+        while (log.size() < 256 * 1024)
+            log += R"({"level": "info", "message": "request handled", "id": )" + std::to_string(log.size()) + "}\n";
+
+        std::vector<std::byte> bytes(log.size());
+        std::transform(log.begin(), log.end(), bytes.begin(), [](char c) {
+            return std::byte(c);
+        });
+
+        auto [encoding, wire_size]
+            = proxy.call<std::tuple<std::byte, uint64_t>>("WireSize", easydbuspp::compressed_bytes {bytes});
+
+        if (encoding != std::byte {1} || wire_size >= bytes.size() / 4)
+            throw std::runtime_error("Large compressible payload was not compressed!");
+
+        std::tie(encoding, wire_size) = proxy.call<std::tuple<std::byte, uint64_t>>(
+            "WireSize", easydbuspp::compressed_bytes {std::vector<std::byte>(16, std::byte {'a'})});
+
+        if (encoding != std::byte {0} || wire_size != 16)
+            throw std::runtime_error("Payload below the threshold should not have been compressed!");
+
+        if (proxy.call<easydbuspp::compressed_bytes>("Echo", easydbuspp::compressed_bytes {bytes}).bytes() != bytes)
+            throw std::runtime_error("'Echo' did not return the expected value!");
+
+        if (!proxy.call<easydbuspp::compressed_bytes>("Echo", easydbuspp::compressed_bytes {}).empty())
+            throw std::runtime_error("'Echo' did not return an empty array!");
+
+        easydbuspp::proxy introspectable {proxy_session_manager, BUS_NAME, "org.freedesktop.DBus.Introspectable",
+                                          OBJECT_PATH};
+
+        if (introspectable.call<std::string>("Introspect").find("org.easydbuspp.Compression") == std::string::npos)
+            throw std::runtime_error("Compressed arguments are not advertised in the introspection data!");
+
+        easydbuspp::main_loop::instance().stop();
+        easydbuspp::main_loop::instance().wait();
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,129 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include <chrono>
+#include <easydbuspp.h>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+int main()
+{
+    using namespace std::chrono_literals;
+
+    try {
+        const std::string               BUS_NAME {"net.test.EasyDBuspp.Test"};
+        const std::string               INTERFACE_NAME {"net.test.EasyDBuspp.TestInterface"};
+        const easydbuspp::object_path_t OBJECT_PATH {"/net/test/EasyDBuspp/TestObject"};
+        const std::thread::id           MAIN_THREAD {std::this_thread::get_id()};
+
+        std::mutex      threads_mutex;
+        std::thread::id getter_thread;
+        std::thread::id signal_thread;
+        int             last_counter {0};
+
+        auto wait_until = [&threads_mutex](auto&& condition) {
+            for (int i = 0; i < 100; ++i) {
+                {
+                    std::lock_guard lock {threads_mutex};
+
+                    if (condition())
+                        return;
+                }
+
+                std::this_thread::sleep_for(50ms);
+            }
+
+            throw std::runtime_error("Timed out waiting for the dispatch thread!");
+        };
+
+        // Nothing in this test runs the main_loop: both session_managers dispatch on threads of their own.
+        easydbuspp::property_cell<int> counter {0};
+        easydbuspp::session_manager    obj_session_manager {easydbuspp::bus_type_t::SESSION, BUS_NAME,
+                                                            easydbuspp::dispatch_t::OWN_THREAD};
+        easydbuspp::object             object {obj_session_manager, INTERFACE_NAME, OBJECT_PATH};
+
+        object.add_property<int>(
+            "Answer",
+            [&] {
+                std::lock_guard lock {threads_mutex};
+                getter_thread = std::this_thread::get_id();
+                return 42;
+            },
+            {});
+
+        object.add_property("Counter", counter, true);
+
+        // The batching timer must run on the private context too, or the batch would never be sent.
+        object.coalesce_property_changes(20ms);
+
+        easydbuspp::session_manager proxy_session_manager {easydbuspp::bus_type_t::SESSION,
+                                                           easydbuspp::dispatch_t::OWN_THREAD};
+
+        easydbuspp::org_freedesktop_dbus_proxy dbus_proxy {proxy_session_manager};
+
+        for (int i = 0; !dbus_proxy.call<bool>("NameHasOwner", BUS_NAME); ++i) {
+            if (i == 100)
+                throw std::runtime_error("Timed out waiting for the bus name!");
+
+            std::this_thread::sleep_for(50ms);
+        }
+
+        easydbuspp::proxy proxy {proxy_session_manager, BUS_NAME, INTERFACE_NAME, OBJECT_PATH};
+
+        if (proxy.property<int>("Answer") != 42)
+            throw std::runtime_error("Unexpected Answer value!");
+
+        {
+            std::lock_guard lock {threads_mutex};
+
+            if (getter_thread == std::thread::id {} || getter_thread == MAIN_THREAD)
+                throw std::runtime_error("The getter did not run on the dispatch thread!");
+        }
+
+        auto subscription = proxy_session_manager.signal_subscribe(
+            "PropertiesChanged",
+            [&](const std::string&, const std::map<std::string, easydbuspp::raw_variant>& changed,
+                const std::vector<std::string>&) {
+                std::lock_guard lock {threads_mutex};
+
+                signal_thread = std::this_thread::get_id();
+
+                if (auto it = changed.find("Counter"); it != changed.end())
+                    last_counter = g_variant_get_int32(it->second.get());
+            },
+            BUS_NAME, "org.freedesktop.DBus.Properties", OBJECT_PATH);
+
+        counter.store(1);
+        counter.store(2);
+
+        wait_until([&] {
+            return last_counter == 2;
+        });
+
+        if (signal_thread == MAIN_THREAD)
+            throw std::runtime_error("The signal was not delivered on the dispatch thread!");
+
+        // Objects created once the connection is up get registered on the dispatch thread, too, soon after.
+        easydbuspp::object late {obj_session_manager, INTERFACE_NAME, OBJECT_PATH / "Late"};
+        late.add_property("Name", std::string {"Late"});
+
+        easydbuspp::proxy late_proxy {proxy_session_manager, BUS_NAME, INTERFACE_NAME, OBJECT_PATH / "Late"};
+
+        wait_until([&] {
+            try {
+                return late_proxy.property<std::string>("Name") == "Late";
+            } catch (const std::exception&) {
+                // Not registered yet.
+                return false;
+            }
+        });
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
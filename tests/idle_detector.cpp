@@ -0,0 +1,96 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include <atomic>
+#include <chrono>
+#include <easydbuspp.h>
+#include <iostream>
+#include <thread>
+
+int main()
+{
+    using namespace std::chrono_literals;
+
+    try {
+        const std::string               BUS_NAME {"net.test.EasyDBuspp.Test"};
+        const std::string               INTERFACE_NAME {"net.test.EasyDBuspp.TestInterface"};
+        const easydbuspp::object_path_t OBJECT_PATH {"/net/test/EasyDBuspp/TestObject"};
+
+        // Set up an object.
+        easydbuspp::session_manager obj_session_manager {easydbuspp::bus_type_t::SESSION, BUS_NAME};
+        easydbuspp::object          object {obj_session_manager, INTERFACE_NAME, OBJECT_PATH};
+
+        object.add_method("Ping", [] {
+        });
+
+        // Per-object timeouts: one object is kept busy, the other is not.
+        const easydbuspp::object_path_t BUSY_OBJECT_PATH {"/net/test/EasyDBuspp/BusyObject"};
+        const easydbuspp::object_path_t IDLE_OBJECT_PATH {"/net/test/EasyDBuspp/IdleObject"};
+
+        easydbuspp::object busy_object {obj_session_manager, INTERFACE_NAME, BUSY_OBJECT_PATH};
+        busy_object.add_method("Ping", [] {
+        });
+
+        auto idle_object = std::make_unique<easydbuspp::object>(obj_session_manager, INTERFACE_NAME, IDLE_OBJECT_PATH);
+        idle_object->add_method("Ping", [] {
+        });
+
+        easydbuspp::main_loop::instance().run_async();
+
+        // Set up a proxy to access the object.
+        easydbuspp::session_manager proxy_session_manager {easydbuspp::bus_type_t::SESSION};
+        easydbuspp::proxy           proxy {proxy_session_manager, BUS_NAME, INTERFACE_NAME, OBJECT_PATH};
+        easydbuspp::proxy           busy_proxy {proxy_session_manager, BUS_NAME, INTERFACE_NAME, BUSY_OBJECT_PATH};
+
+        std::atomic<bool> busy_object_idle {false};
+        std::atomic<bool> idle_object_idle {false};
+
+        easydbuspp::idle_detector::instance().watch(busy_object, 300ms, [&busy_object_idle] {
+            busy_object_idle = true;
+        });
+
+        // Idle objects can be evicted from the callback.
+        easydbuspp::idle_detector::instance().watch(*idle_object, 300ms, [&idle_object, &idle_object_idle] {
+            idle_object.reset();
+            idle_object_idle = true;
+        });
+
+        for (int i = 0; i < 10; ++i) {
+            busy_proxy.call<void>("Ping");
+            std::this_thread::sleep_for(100ms);
+        }
+
+        if (!idle_object_idle || busy_object_idle)
+            throw std::runtime_error("Per-object idle callbacks did not match the objects' activity!");
+
+        std::this_thread::sleep_for(600ms);
+
+        if (!busy_object_idle)
+            throw std::runtime_error("The busy object's idle callback has not been called after it went idle!");
+
+        easydbuspp::idle_detector::instance().enable(500ms);
+
+        // Requests keep coming for three times the timeout, so the main loop must still be running.
+        for (int i = 0; i < 15; ++i) {
+            proxy.call<void>("Ping");
+            std::this_thread::sleep_for(100ms);
+        }
+
+        // Now there are no more requests: the main loop should stop on its own, soon after the timeout.
+        auto idle_start = std::chrono::steady_clock::now();
+
+        easydbuspp::main_loop::instance().wait();
+
+        auto idle_time = std::chrono::steady_clock::now() - idle_start;
+
+        if (idle_time < 300ms || idle_time > 2s)
+            throw std::runtime_error("The idle detector did not stop the main loop after the expected timeout!");
+
+        easydbuspp::idle_detector::instance().disable();
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
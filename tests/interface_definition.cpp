@@ -0,0 +1,134 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include <chrono>
+#include <easydbuspp.h>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <vector>
+
+namespace {
+
+struct counter {
+    int count {0};
+};
+
+} // end of anonymous namespace
+
+int main()
+{
+    try {
+        const std::string               BUS_NAME {"net.test.EasyDBuspp.Test"};
+        const std::string               INTERFACE_NAME {"net.test.EasyDBuspp.Counter"};
+        const easydbuspp::object_path_t COUNTERS_PATH {"/net/test/EasyDBuspp/Counters"};
+        const int                       COUNTER_COUNT {1000};
+
+        // One definition, shared by all the counters.
+        auto definition = std::make_shared<easydbuspp::interface_definition>(INTERFACE_NAME);
+
+        definition->add_method(
+            "Increment",
+            [](const easydbuspp::dbus_context& context, int step) {
+                return context.state_as<counter>()->count += step;
+            },
+            {"step"}, {"count"});
+
+        definition->add_property<int>(
+            "Count",
+            [](const easydbuspp::dbus_context& context) {
+                return context.state_as<counter>()->count;
+            },
+            [](const easydbuspp::dbus_context& context, const int& count) {
+                if (count < 0)
+                    return false;
+
+                context.state_as<counter>()->count = count;
+                return true;
+            });
+
+        auto overflow = definition->add_broadcast_signal<int>("Overflow", {"count"});
+
+        easydbuspp::session_manager obj_session_manager {easydbuspp::bus_type_t::SESSION, BUS_NAME};
+
+        std::vector<counter>          counters(COUNTER_COUNT);
+        std::list<easydbuspp::object> objects;
+
+        for (int i = 0; i < COUNTER_COUNT; ++i)
+            objects.emplace_back(obj_session_manager, definition, COUNTERS_PATH / ("counter" + std::to_string(i)),
+                                 &counters[i]);
+
+        // Objects implementing a shared definition can't change it.
+        bool exception_caught {false};
+
+        try {
+            objects.front().add_method("Decrement", [] { });
+        } catch (const std::exception&) {
+            exception_caught = true;
+        }
+
+        if (!exception_caught)
+            throw std::runtime_error("Adding a method to a shared definition succeeded, and it shouldn't have!");
+
+        easydbuspp::main_loop::instance().run_async();
+
+        // Registering all the objects takes a while, and the bus name is only requested afterwards.
+        easydbuspp::bus_watcher watcher {easydbuspp::bus_type_t::SESSION, BUS_NAME};
+        watcher.wait_for(std::chrono::seconds {10});
+
+        const easydbuspp::object_path_t COUNTER7_PATH {COUNTERS_PATH / "counter7"};
+        const easydbuspp::object_path_t COUNTER999_PATH {COUNTERS_PATH / "counter999"};
+
+        easydbuspp::session_manager proxy_session_manager {easydbuspp::bus_type_t::SESSION};
+        easydbuspp::proxy           counter7 {proxy_session_manager, BUS_NAME, INTERFACE_NAME, COUNTER7_PATH};
+        easydbuspp::proxy           counter999 {proxy_session_manager, BUS_NAME, INTERFACE_NAME, COUNTER999_PATH};
+
+        if (counter7.call<int>("Increment", 5) != 5 || counter7.call<int>("Increment", 2) != 7
+            || counter999.call<int>("Increment", 1) != 1)
+            throw std::runtime_error("Method calls did not get the right object state!");
+
+        if (counters[7].count != 7 || counters[999].count != 1 || counters[8].count != 0)
+            throw std::runtime_error("Method calls changed the wrong object state!");
+
+        counter999.property("Count", 42);
+
+        if (counter999.property<int>("Count") != 42 || counter7.property<int>("Count") != 7)
+            throw std::runtime_error("Properties did not get the right object state!");
+
+        exception_caught = false;
+
+        try {
+            counter999.property("Count", -1);
+        } catch (const std::exception&) {
+            exception_caught = true;
+        }
+
+        if (!exception_caught || counters[999].count != 42)
+            throw std::runtime_error("A rejected property write went through!");
+
+        overflow(objects.back(), counters[999].count);
+
+        // Neither can anyone else, once objects are serving it.
+        exception_caught = false;
+
+        try {
+            definition->add_method("Decrement", [] { });
+        } catch (const std::exception&) {
+            exception_caught = true;
+        }
+
+        if (!exception_caught)
+            throw std::runtime_error("Changing a definition that's being served succeeded, and it shouldn't have!");
+
+        if (definition->introspection_xml().find("<method name='Increment'>") == std::string::npos)
+            throw std::runtime_error("Unexpected introspection XML!");
+
+        easydbuspp::main_loop::instance().stop();
+        easydbuspp::main_loop::instance().wait();
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -35,6 +35,22 @@ auto square_int_values(const dictionary_type_t& m)
     return ret;
 }
 
+// Plain structs marshalled as D-Bus structs, without going through std::tuple.
+struct position {
+    double latitude;
+    double longitude;
+};
+
+EASYDBUSPP_STRUCT(position, latitude, longitude)
+
+struct place {
+    std::string name;
+    position    location;
+    uint32_t    visits;
+};
+
+EASYDBUSPP_STRUCT(place, name, location, visits)
+
 } // end of anonymous namespace
 
 int main()
@@ -88,6 +104,45 @@ int main()
             return bytes;
         });
 
+        object.add_method("ReturnStringVariant", [] {
+            return variant_type_t {"not an int"};
+        });
+
+        object.add_method("RelayRawVariant", [](const easydbuspp::raw_variant& payload) {
+            return payload;
+        });
+
+        object.add_method("LazyLookup", [](const easydbuspp::lazy<dictionary_type_t>& dict,
+                                           const easydbuspp::lazy<std::vector<uint16_t>>& v) {
+            auto value = dict.find("key2");
+
+            if (!value || dict.find("missing_key"))
+                throw std::runtime_error("Unexpected lazy dictionary lookup result!");
+
+            return std::tuple {std::get<int>(*value), v.at(v.size() - 1)};
+        });
+
+        object.add_method("MostVisited", [](const std::vector<place>& places) {
+            return *std::max_element(places.begin(), places.end(), [](const place& a, const place& b) {
+                return a.visits < b.visits;
+            });
+        });
+
+        object.add_method("PmrArguments", [](const std::pmr::vector<std::pmr::string>& names) {
+            auto* arena = easydbuspp::request_memory_resource();
+
+            if (arena == std::pmr::get_default_resource())
+                throw std::runtime_error("No request arena active in method handler!");
+
+            if (names.get_allocator().resource() != arena
+                || std::any_of(names.begin(), names.end(), [arena](const auto& name) {
+                       return name.get_allocator().resource() != arena;
+                   }))
+                throw std::runtime_error("std::pmr arguments not decoded into the request arena!");
+
+            return names.size();
+        });
+
         easydbuspp::main_loop::instance().run_async();
 
         // Set up a proxy to access the object.
@@ -140,6 +195,29 @@ int main()
                 throw std::runtime_error("'TransformVector2x' did not return the expected value!");
         }
 
+        auto [lazy_dict_value, lazy_last_element] = proxy.call<std::tuple<int, uint16_t>>("LazyLookup", input, v);
+
+        if (lazy_dict_value != std::get<int>(input["key2"]) || lazy_last_element != v.back())
+            throw std::runtime_error("'LazyLookup' did not return the expected value!");
+
+        if (easydbuspp::to_dbus_type_string<std::vector<place>>() != "a(s(dd)u)")
+            throw std::runtime_error("Unexpected D-Bus type for a vector of structs!");
+
+        std::vector<place> places {{"home", {45.75, 21.22}, 700}, {"work", {44.43, 26.1}, 900}, {"gym", {0, 0}, 5}};
+
+        auto most_visited = proxy.call<place>("MostVisited", places);
+
+        if (most_visited.name != "work" || most_visited.location.longitude != 26.1 || most_visited.visits != 900)
+            throw std::runtime_error("'MostVisited' did not return the expected value!");
+
+        std::vector<std::string> pmr_names {"first name that is too long for the small string optimization", "second"};
+
+        if (proxy.call<size_t>("PmrArguments", pmr_names) != pmr_names.size())
+            throw std::runtime_error("'PmrArguments' did not return the expected value!");
+
+        if (easydbuspp::request_memory_resource() != std::pmr::get_default_resource())
+            throw std::runtime_error("Request arena active outside of a method handler!");
+
         bool exception_caught {false};
 
         try {
@@ -162,6 +240,27 @@ int main()
         if (bytes != bytes_out)
             throw std::runtime_error("Unexpected value returned by 'TakeAVectorOfByteAndReturnIt'!");
 
+        if (std::get<std::string>(proxy.call<variant_type_t>("ReturnStringVariant")) != "not an int")
+            throw std::runtime_error("'ReturnStringVariant' did not return the expected value!");
+
+        exception_caught = false;
+
+        try {
+            proxy.call<std::variant<int, double>>("ReturnStringVariant");
+        } catch (const std::exception&) {
+            exception_caught = true;
+        }
+
+        if (!exception_caught)
+            throw std::runtime_error("Extracting a std::variant with no matching alternative should have thrown!");
+
+        easydbuspp::raw_variant payload {easydbuspp::to_gvariant(input)};
+
+        auto relayed = proxy.call<easydbuspp::raw_variant>("RelayRawVariant", payload);
+
+        if (easydbuspp::from_gvariant<dictionary_type_t>(relayed.get()) != input)
+            throw std::runtime_error("'RelayRawVariant' did not return the expected value!");
+
         easydbuspp::main_loop::instance().stop();
         easydbuspp::main_loop::instance().wait();
 
@@ -0,0 +1,166 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include <chrono>
+#include <easydbuspp.h>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+int main()
+{
+    using namespace std::chrono_literals;
+
+    try {
+        const std::string               BUS_NAME {"net.test.EasyDBuspp.Test"};
+        const std::string               WIDGET_INTERFACE {"net.test.EasyDBuspp.Widget"};
+        const std::string               BATTERY_INTERFACE {"net.test.EasyDBuspp.Battery"};
+        const easydbuspp::object_path_t ROOT_PATH {"/net/test/EasyDBuspp"};
+        const easydbuspp::object_path_t WIDGET1_PATH {ROOT_PATH / "Widgets" / "w1"};
+        const easydbuspp::object_path_t WIDGET2_PATH {ROOT_PATH / "Widgets" / "w2"};
+
+        using managed_objects_t = std::map<easydbuspp::object_path_t, easydbuspp::interfaces_and_properties_t>;
+
+        // A second interface, shared by both widgets.
+        auto battery = std::make_shared<easydbuspp::interface_definition>(BATTERY_INTERFACE);
+
+        battery->add_property<int>(
+            "Level",
+            [](const easydbuspp::dbus_context& context) {
+                // Objects with their own interface (like widget1) have no state.
+                const int* level = context.state_as<int>();
+                return level ? *level : 0;
+            },
+            {});
+
+        // Set up the manager and a couple of objects.
+        easydbuspp::session_manager obj_session_manager {easydbuspp::bus_type_t::SESSION, BUS_NAME};
+        easydbuspp::object_manager  manager {obj_session_manager, ROOT_PATH};
+        easydbuspp::object          widget1 {obj_session_manager, WIDGET_INTERFACE, WIDGET1_PATH};
+        easydbuspp::object          elsewhere {obj_session_manager, WIDGET_INTERFACE, "/net/test/Elsewhere"};
+
+        widget1.add_property("Name", std::string {"First"});
+        widget1.add_interface(battery);
+
+        // GetManagedObjects runs getters like this one without holding on to any of the session's locks.
+        widget1.add_property<int>(
+            "Scratch",
+            [&obj_session_manager, &WIDGET_INTERFACE] {
+                easydbuspp::object scratch {obj_session_manager, WIDGET_INTERFACE, "/net/test/Scratch"};
+                return 0;
+            },
+            {});
+
+        easydbuspp::main_loop::instance().run_async();
+
+        easydbuspp::bus_watcher watcher {easydbuspp::bus_type_t::SESSION, BUS_NAME};
+        watcher.wait_for(10s);
+
+        // Set up the client side.
+        easydbuspp::session_manager proxy_session_manager {easydbuspp::bus_type_t::SESSION};
+        easydbuspp::proxy           manager_proxy {proxy_session_manager, BUS_NAME,
+                                         easydbuspp::object_manager::INTERFACE_NAME, ROOT_PATH};
+        easydbuspp::proxy           battery_proxy {proxy_session_manager, BUS_NAME, BATTERY_INTERFACE, WIDGET1_PATH};
+
+        std::mutex                             signals_mutex;
+        managed_objects_t                      added;
+        std::vector<easydbuspp::object_path_t> removed_paths;
+        std::vector<std::vector<std::string>>  removed_interfaces;
+
+        auto added_subscription = proxy_session_manager.signal_subscribe(
+            "InterfacesAdded",
+            [&](const easydbuspp::object_path_t& path, const easydbuspp::interfaces_and_properties_t& interfaces) {
+                std::lock_guard lock {signals_mutex};
+                added[path] = interfaces;
+            });
+
+        auto removed_subscription = proxy_session_manager.signal_subscribe(
+            "InterfacesRemoved",
+            [&](const easydbuspp::object_path_t& path, const std::vector<std::string>& interfaces) {
+                std::lock_guard lock {signals_mutex};
+                removed_paths.push_back(path);
+                removed_interfaces.push_back(interfaces);
+            });
+
+        auto wait_until = [&signals_mutex](auto&& condition) {
+            for (int i = 0; i < 100; ++i) {
+                {
+                    std::lock_guard lock {signals_mutex};
+
+                    if (condition())
+                        return;
+                }
+
+                std::this_thread::sleep_for(50ms);
+            }
+
+            throw std::runtime_error("Timed out waiting for an ObjectManager signal!");
+        };
+
+        // Both interfaces are served from the same path.
+        if (battery_proxy.property<int>("Level") != 0)
+            throw std::runtime_error("Unexpected Level value!");
+
+        auto objects = manager_proxy.call<managed_objects_t>("GetManagedObjects");
+
+        if (objects.size() != 1 || objects.count(WIDGET1_PATH) != 1)
+            throw std::runtime_error("GetManagedObjects returned the wrong objects!");
+
+        auto& widget1_interfaces = objects[WIDGET1_PATH];
+
+        if (widget1_interfaces.size() != 2
+            || std::string {g_variant_get_string(widget1_interfaces[WIDGET_INTERFACE]["Name"].get(), nullptr)}
+                != "First"
+            || g_variant_get_int32(widget1_interfaces[BATTERY_INTERFACE]["Level"].get()) != 0)
+            throw std::runtime_error("GetManagedObjects returned the wrong interfaces or properties!");
+
+        // Objects created on the fly get registered and announced.
+        int  widget2_level {42};
+        auto widget2
+            = std::make_unique<easydbuspp::object>(obj_session_manager, battery, WIDGET2_PATH, &widget2_level);
+
+        wait_until([&] {
+            return added.count(WIDGET2_PATH) == 1;
+        });
+
+        if (g_variant_get_int32(added[WIDGET2_PATH][BATTERY_INTERFACE]["Level"].get()) != 42)
+            throw std::runtime_error("InterfacesAdded carried the wrong properties!");
+
+        easydbuspp::proxy widget2_proxy {proxy_session_manager, BUS_NAME, BATTERY_INTERFACE, WIDGET2_PATH};
+
+        if (widget2_proxy.property<int>("Level") != 42)
+            throw std::runtime_error("An object created on the fly is not reachable!");
+
+        if (manager_proxy.call<managed_objects_t>("GetManagedObjects").size() != 2)
+            throw std::runtime_error("GetManagedObjects did not pick up the new object!");
+
+        // Removing an interface, or a whole object, is announced too.
+        widget1.remove_interface(BATTERY_INTERFACE);
+        widget2.reset();
+
+        wait_until([&] {
+            return removed_paths.size() == 2;
+        });
+
+        const std::vector<std::string> BATTERY_ONLY {BATTERY_INTERFACE};
+
+        if (removed_paths[0] != WIDGET1_PATH || removed_paths[1] != WIDGET2_PATH
+            || removed_interfaces[0] != BATTERY_ONLY || removed_interfaces[1] != BATTERY_ONLY)
+            throw std::runtime_error("InterfacesRemoved carried the wrong data!");
+
+        objects = manager_proxy.call<managed_objects_t>("GetManagedObjects");
+
+        if (objects.size() != 1 || objects[WIDGET1_PATH].size() != 1)
+            throw std::runtime_error("GetManagedObjects still shows removed interfaces!");
+
+        easydbuspp::main_loop::instance().stop();
+        easydbuspp::main_loop::instance().wait();
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
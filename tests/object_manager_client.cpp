@@ -0,0 +1,230 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <easydbuspp.h>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main()
+{
+    using namespace std::chrono_literals;
+
+    try {
+        const std::string               BUS_NAME {"net.test.EasyDBuspp.Test"};
+        const std::string               WIDGET_INTERFACE {"net.test.EasyDBuspp.Widget"};
+        const std::string               BATTERY_INTERFACE {"net.test.EasyDBuspp.Battery"};
+        const easydbuspp::object_path_t ROOT_PATH {"/net/test/EasyDBuspp"};
+        const easydbuspp::object_path_t WIDGET1_PATH {ROOT_PATH / "Widgets" / "w1"};
+        const easydbuspp::object_path_t WIDGET2_PATH {ROOT_PATH / "Widgets" / "w2"};
+
+        auto battery = std::make_shared<easydbuspp::interface_definition>(BATTERY_INTERFACE);
+
+        battery->add_property<int>(
+            "Level",
+            [](const easydbuspp::dbus_context& context) {
+                const int* level = context.state_as<int>();
+                return level ? *level : 0;
+            },
+            {});
+
+        // Set up the manager and an object. The cell must outlive the object.
+        easydbuspp::property_cell<std::string> name {"First"};
+        easydbuspp::session_manager            obj_session_manager {easydbuspp::bus_type_t::SESSION, BUS_NAME};
+        easydbuspp::object_manager             manager {obj_session_manager, ROOT_PATH};
+        easydbuspp::object                     widget1 {obj_session_manager, WIDGET_INTERFACE, WIDGET1_PATH};
+
+        widget1.add_property("Name", name, true);
+        widget1.add_interface(battery);
+
+        easydbuspp::main_loop::instance().run_async();
+
+        easydbuspp::bus_watcher watcher {easydbuspp::bus_type_t::SESSION, BUS_NAME};
+        watcher.wait_for(10s);
+
+        // Set up the client side mirror.
+        easydbuspp::session_manager       proxy_session_manager {easydbuspp::bus_type_t::SESSION};
+        easydbuspp::object_manager_client client {proxy_session_manager, BUS_NAME, ROOT_PATH};
+
+        std::mutex                             handlers_mutex;
+        std::vector<easydbuspp::object_path_t> added_paths;
+        std::vector<easydbuspp::object_path_t> removed_paths;
+        std::vector<std::string>               changed_properties;
+
+        client.interfaces_added_handler([&](const easydbuspp::object_path_t& path, const std::vector<std::string>&) {
+            std::lock_guard lock {handlers_mutex};
+            added_paths.push_back(path);
+        });
+
+        client.interfaces_removed_handler([&](const easydbuspp::object_path_t& path, const std::vector<std::string>&) {
+            std::lock_guard lock {handlers_mutex};
+            removed_paths.push_back(path);
+        });
+
+        client.properties_changed_handler(
+            [&](const easydbuspp::object_path_t&, const std::string&, const std::vector<std::string>& names) {
+                std::lock_guard lock {handlers_mutex};
+                changed_properties.insert(changed_properties.end(), names.begin(), names.end());
+            });
+
+        auto wait_until = [](auto&& condition) {
+            for (int i = 0; i < 100; ++i) {
+                if (condition())
+                    return;
+
+                std::this_thread::sleep_for(50ms);
+            }
+
+            throw std::runtime_error("Timed out waiting for the mirror to update!");
+        };
+
+        // The initial snapshot.
+        if (client.object_paths() != std::vector<easydbuspp::object_path_t> {WIDGET1_PATH})
+            throw std::runtime_error("The mirror holds the wrong objects!");
+
+        if (client.interface_names(WIDGET1_PATH).size() != 2 || !client.has_interface(WIDGET1_PATH, BATTERY_INTERFACE))
+            throw std::runtime_error("The mirror holds the wrong interfaces!");
+
+        if (client.property<std::string>(WIDGET1_PATH, WIDGET_INTERFACE, "Name") != "First"
+            || client.property<int>(WIDGET1_PATH, BATTERY_INTERFACE, "Level") != 0)
+            throw std::runtime_error("The mirror holds the wrong property values!");
+
+        // Property changes are applied as they're signalled.
+        name.store("Second");
+
+        wait_until([&] {
+            return client.property<std::string>(WIDGET1_PATH, WIDGET_INTERFACE, "Name") == "Second";
+        });
+
+        // So are objects created on the fly.
+        int  widget2_level {42};
+        auto widget2
+            = std::make_unique<easydbuspp::object>(obj_session_manager, battery, WIDGET2_PATH, &widget2_level);
+
+        wait_until([&] {
+            return client.has_interface(WIDGET2_PATH, BATTERY_INTERFACE);
+        });
+
+        if (client.property<int>(WIDGET2_PATH, BATTERY_INTERFACE, "Level") != 42
+            || client.object_paths(BATTERY_INTERFACE).size() != 2)
+            throw std::runtime_error("An object created on the fly is not mirrored correctly!");
+
+        // And removed interfaces and objects.
+        widget1.remove_interface(BATTERY_INTERFACE);
+        widget2.reset();
+
+        wait_until([&] {
+            return client.object_paths().size() == 1 && !client.has_interface(WIDGET1_PATH, BATTERY_INTERFACE);
+        });
+
+        bool threw {false};
+
+        try {
+            client.property<int>(WIDGET2_PATH, BATTERY_INTERFACE, "Level");
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+
+        if (!threw)
+            throw std::runtime_error("Reading a property of a removed object did not throw!");
+
+        {
+            std::lock_guard lock {handlers_mutex};
+
+            if (added_paths != std::vector<easydbuspp::object_path_t> {WIDGET2_PATH})
+                throw std::runtime_error("The interfaces added handler got the wrong paths!");
+
+            if (removed_paths != std::vector<easydbuspp::object_path_t> {WIDGET1_PATH, WIDGET2_PATH})
+                throw std::runtime_error("The interfaces removed handler got the wrong paths!");
+
+            if (changed_properties != std::vector<std::string> {"Name"})
+                throw std::runtime_error("The properties changed handler got the wrong names!");
+        }
+
+        // A fresh snapshot agrees with the incrementally updated mirror.
+        client.refresh();
+
+        if (client.object_paths() != std::vector<easydbuspp::object_path_t> {WIDGET1_PATH}
+            || client.property<std::string>(WIDGET1_PATH, WIDGET_INTERFACE, "Name") != "Second")
+            throw std::runtime_error("The refreshed mirror is wrong!");
+
+        // An object created on the fly is registered (and announced) along with what's added to it right after.
+        const easydbuspp::object_path_t WIDGET3_PATH {ROOT_PATH / "Widgets" / "w3"};
+
+        easydbuspp::object widget3 {obj_session_manager, WIDGET_INTERFACE, WIDGET3_PATH};
+
+        widget3.add_interface(battery);
+        widget3.add_property("Name", std::string {"Third"});
+
+        auto widget3_announcements = [&] {
+            std::lock_guard lock {handlers_mutex};
+            return std::count(added_paths.begin(), added_paths.end(), WIDGET3_PATH);
+        };
+
+        wait_until([&] {
+            try {
+                return client.property<std::string>(WIDGET3_PATH, WIDGET_INTERFACE, "Name") == "Third"
+                       && client.has_interface(WIDGET3_PATH, BATTERY_INTERFACE);
+            } catch (const std::runtime_error&) {
+                // Not announced yet.
+                return false;
+            }
+        });
+
+        // At most, the dispatch thread got to the bare object before the rest was added.
+        auto announcements = widget3_announcements();
+
+        if (announcements == 0 || announcements > 2)
+            throw std::runtime_error("The object created on the fly was announced the wrong number of times!");
+
+        // The object stays on the bus while its own interface changes.
+        easydbuspp::proxy battery_proxy {proxy_session_manager, BUS_NAME, BATTERY_INTERFACE, WIDGET3_PATH};
+        std::atomic<bool> done {false};
+        std::string       reader_error;
+
+        std::thread reader([&] {
+            try {
+                while (!done)
+                    if (battery_proxy.property<int>("Level") != 0)
+                        throw std::runtime_error("Unexpected Level value!");
+            } catch (const std::exception& e) {
+                reader_error = e.what();
+            }
+        });
+
+        for (int i = 0; i < 20; ++i)
+            widget3.add_property("Extra" + std::to_string(i), int {i});
+
+        done = true;
+        reader.join();
+
+        if (!reader_error.empty())
+            throw std::runtime_error("The object dropped off the bus while changing: " + reader_error);
+
+        // What an announced object gains arrives as property changes, not as more announcements.
+        wait_until([&] {
+            try {
+                return client.property<int>(WIDGET3_PATH, WIDGET_INTERFACE, "Extra19") == 19;
+            } catch (const std::runtime_error&) {
+                return false;
+            }
+        });
+
+        if (widget3_announcements() != announcements)
+            throw std::runtime_error("Adding properties announced the object again!");
+
+        easydbuspp::main_loop::instance().stop();
+        easydbuspp::main_loop::instance().wait();
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
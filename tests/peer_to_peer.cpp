@@ -0,0 +1,107 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include <atomic>
+#include <chrono>
+#include <easydbuspp.h>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+int main()
+{
+    using namespace std::chrono_literals;
+
+    try {
+        const std::string               INTERFACE_NAME {"net.test.EasyDBuspp.TestInterface"};
+        const easydbuspp::object_path_t OBJECT_PATH {"/net/test/EasyDBuspp/TestObject"};
+
+        std::atomic<int> peers_seen {0};
+
+        // Every peer gets an object of its own.
+        auto on_peer = [&](easydbuspp::session_manager& peer) {
+            auto obj = std::make_shared<easydbuspp::object>(peer, INTERFACE_NAME, OBJECT_PATH);
+
+            obj->add_method("Add", [](int a, int b) {
+                return a + b;
+            });
+
+            obj->add_method("Sender", [](const easydbuspp::dbus_context& context) {
+                return context.bus_name;
+            });
+
+            obj->add_property("Peer", int {++peers_seen});
+
+            auto ping = obj->add_broadcast_signal<std::string>("Ping");
+
+            obj->add_method("EmitPing", [ping] {
+                ping("pong");
+            });
+
+            return obj;
+        };
+
+        easydbuspp::peer_server server {"unix:tmpdir=/tmp", on_peer};
+
+        easydbuspp::main_loop::instance().run_async();
+
+        auto wait_until = [](auto&& condition) {
+            for (int i = 0; i < 100; ++i) {
+                if (condition())
+                    return;
+
+                std::this_thread::sleep_for(50ms);
+            }
+
+            throw std::runtime_error("Timed out waiting for the peer server!");
+        };
+
+        {
+            // No bus involved: the proxy's bus name doesn't matter.
+            easydbuspp::session_manager client {server.client_address()};
+            easydbuspp::proxy           proxy {client, {}, INTERFACE_NAME, OBJECT_PATH};
+
+            if (proxy.call<int>("Add", 2, 3) != 5)
+                throw std::runtime_error("Unexpected Add() result!");
+
+            if (!proxy.call<std::string>("Sender").empty() || !client.unique_bus_name().empty())
+                throw std::runtime_error("A peer-to-peer connection has bus names!");
+
+            if (proxy.property<int>("Peer") != 1 || server.peer_count() != 1)
+                throw std::runtime_error("Unexpected peer count!");
+
+            // Signals make it across too.
+            std::atomic<bool> pinged {false};
+
+            auto subscription = client.signal_subscribe("Ping", [&pinged](const std::string& s) {
+                pinged = (s == "pong");
+            });
+
+            proxy.call<void>("EmitPing");
+
+            wait_until([&pinged] {
+                return pinged.load();
+            });
+
+            // A second peer gets objects of its own.
+            easydbuspp::session_manager second_client {server.client_address()};
+            easydbuspp::proxy           second_proxy {second_client, {}, INTERFACE_NAME, OBJECT_PATH};
+
+            if (second_proxy.property<int>("Peer") != 2 || server.peer_count() != 2)
+                throw std::runtime_error("Unexpected second peer count!");
+        }
+
+        // Peers going away take their objects with them.
+        wait_until([&server] {
+            return server.peer_count() == 0;
+        });
+
+        easydbuspp::main_loop::instance().stop();
+        easydbuspp::main_loop::instance().wait();
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -3,8 +3,12 @@
 // SPDX-License-Identifier: AGPL-3.0-only
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <easydbuspp.h>
 #include <iostream>
+#include <mutex>
+#include <thread>
 
 int main()
 {
@@ -43,6 +47,15 @@ int main()
                 return true;
             });
 
+        std::atomic<int> getter_calls {0};
+
+        object.add_property<int>(
+            "CountedGetter",
+            [&getter_calls] {
+                return ++getter_calls;
+            },
+            {});
+
         easydbuspp::main_loop::instance().run_async();
 
         // Set up a proxy to access the object.
@@ -114,6 +127,82 @@ int main()
         if (it1 == rw_prop_ret3.end() || it2 == rw_prop_ret3.end())
             throw std::runtime_error("'FreeJazzMusicians' (method read) is not the expected value!");
 
+        // Batched change notifications: three writes, one signal, only the latest values.
+        using changed_properties_t = std::map<std::string, std::variant<double, std::vector<std::string>>>;
+
+        std::mutex           changed_mutex;
+        changed_properties_t changed_properties;
+        std::atomic<int>     properties_changed_signals {0};
+
+        auto properties_changed_subscription = proxy_session_manager.signal_subscribe(
+            "PropertiesChanged",
+            [&](const std::string&, const changed_properties_t& changed, const std::vector<std::string>&) {
+                std::lock_guard lock {changed_mutex};
+                changed_properties = changed;
+                ++properties_changed_signals;
+            },
+            {}, "org.freedesktop.DBus.Properties", OBJECT_PATH);
+
+        object.coalesce_property_changes(std::chrono::milliseconds {100});
+
+        proxy.property("ReadWriteDouble", 2.5);
+        proxy.property("FreeJazzMusicians", std::vector<std::string> {"Ornette Coleman"});
+        proxy.property("ReadWriteDouble", 3.5);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds {500});
+
+        {
+            std::lock_guard lock {changed_mutex};
+
+            if (properties_changed_signals != 1)
+                throw std::runtime_error("Expected a single batched PropertiesChanged signal, got "
+                                         + std::to_string(properties_changed_signals) + "!");
+
+            if (changed_properties.size() != 2 || std::get<double>(changed_properties["ReadWriteDouble"]) != 3.5)
+                throw std::runtime_error("Batched PropertiesChanged signal does not carry the latest values!");
+        }
+
+        // Unchanged writes are dropped: no setter call, no signal.
+        object.coalesce_property_changes(std::chrono::milliseconds {0});
+        object.skip_unchanged_property_writes();
+
+        properties_changed_signals = 0;
+
+        proxy.property("ReadWriteDouble", 3.5);
+        proxy.property("ReadWriteDouble", 4.5);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds {500});
+
+        {
+            std::lock_guard lock {changed_mutex};
+
+            if (properties_changed_signals != 1)
+                throw std::runtime_error("Expected only the changing write to emit PropertiesChanged, got "
+                                         + std::to_string(properties_changed_signals) + " signals!");
+
+            if (std::get<double>(changed_properties["ReadWriteDouble"]) != 4.5)
+                throw std::runtime_error("PropertiesChanged signal does not carry the new value!");
+        }
+
+        // Cached property values: the getter only runs again after invalidation.
+        object.cache_property_values();
+
+        auto first_read  = proxy.property<int>("CountedGetter");
+        auto second_read = proxy.property<int>("CountedGetter");
+
+        if (first_read != second_read || getter_calls != first_read)
+            throw std::runtime_error("'CountedGetter' value has not been cached!");
+
+        object.invalidate_property_value("CountedGetter");
+
+        if (proxy.property<int>("CountedGetter") != first_read + 1)
+            throw std::runtime_error("'CountedGetter' cached value has not been invalidated!");
+
+        proxy.property("ReadWriteDouble", 5.5);
+
+        if (proxy.property<double>("ReadWriteDouble") != 5.5)
+            throw std::runtime_error("'ReadWriteDouble' cached value has not been invalidated by a write!");
+
         easydbuspp::main_loop::instance().stop();
         easydbuspp::main_loop::instance().wait();
 
@@ -0,0 +1,142 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include <atomic>
+#include <chrono>
+#include <easydbuspp.h>
+#include <iostream>
+#include <thread>
+
+int main()
+{
+    try {
+        const std::string               BUS_NAME {"net.test.EasyDBuspp.Test"};
+        const std::string               INTERFACE_NAME {"net.test.EasyDBuspp.TestInterface"};
+        const easydbuspp::object_path_t OBJECT_PATH {"/net/test/EasyDBuspp/TestObject"};
+
+        static_assert(easydbuspp::property_cell<int>::is_atomic);
+        static_assert(!easydbuspp::property_cell<std::vector<std::string>>::is_atomic);
+
+        easydbuspp::property_cell<int>                      counter {0};
+        easydbuspp::property_cell<std::vector<std::string>> musicians {{"Albert Ayler", "Peter Brötzmann"}};
+
+        // Set up an object.
+        easydbuspp::session_manager obj_session_manager {easydbuspp::bus_type_t::SESSION, BUS_NAME};
+        easydbuspp::object          object {obj_session_manager, INTERFACE_NAME, OBJECT_PATH};
+
+        object.add_property("Counter", counter);
+        object.add_property("Musicians", musicians, true);
+
+        easydbuspp::main_loop::instance().run_async();
+
+        // Set up a proxy to access the object.
+        easydbuspp::session_manager proxy_session_manager {easydbuspp::bus_type_t::SESSION};
+        easydbuspp::proxy           proxy {proxy_session_manager, BUS_NAME, INTERFACE_NAME, OBJECT_PATH};
+
+        // Application threads update the cells while the bus reads them.
+        std::atomic<bool> done {false};
+
+        std::thread writer([&] {
+            for (int i = 1; !done; ++i) {
+                counter.store(i);
+                musicians.store(std::vector<std::string>(i % 8 + 1, "Ornette Coleman"));
+                std::this_thread::sleep_for(std::chrono::microseconds {500});
+            }
+        });
+
+        int         last_counter {0};
+        std::string reader_error;
+
+        try {
+            for (int i = 0; i < 200; ++i) {
+                auto current_counter = proxy.property<int>("Counter");
+                auto current         = proxy.property<std::vector<std::string>>("Musicians");
+
+                if (current_counter < last_counter)
+                    throw std::runtime_error("'Counter' went backwards!");
+
+                if (current.empty() || current.size() > 8)
+                    throw std::runtime_error("'Musicians' is not a consistent snapshot!");
+
+                last_counter = current_counter;
+            }
+        } catch (const std::exception& e) {
+            reader_error = e.what();
+        }
+
+        done = true;
+        writer.join();
+
+        if (!reader_error.empty())
+            throw std::runtime_error(reader_error);
+
+        // Set over D-Bus: visible through the cell.
+        proxy.property("Counter", -1);
+
+        if (counter.load() != -1)
+            throw std::runtime_error("'Counter' has not been updated over D-Bus!");
+
+        // store() emits PropertiesChanged for cells added with emit_changes == true.
+        using changed_properties_t = std::map<std::string, std::variant<int, std::vector<std::string>>>;
+
+        std::atomic<int> properties_changed_signals {0};
+
+        auto properties_changed_subscription = proxy_session_manager.signal_subscribe(
+            "PropertiesChanged",
+            [&](const std::string&, const changed_properties_t& changed, const std::vector<std::string>&) {
+                auto it = changed.find("Musicians");
+
+                if (it != changed.end() && std::get<std::vector<std::string>>(it->second).front() == "Sun Ra")
+                    ++properties_changed_signals;
+            },
+            {}, "org.freedesktop.DBus.Properties", OBJECT_PATH);
+
+        musicians.store({"Sun Ra"});
+
+        std::this_thread::sleep_for(std::chrono::milliseconds {500});
+
+        if (properties_changed_signals != 1)
+            throw std::runtime_error("store() has not emitted a PropertiesChanged signal!");
+
+        if (proxy.property<std::vector<std::string>>("Musicians") != std::vector<std::string> {"Sun Ra"})
+            throw std::runtime_error("'Musicians' is not the expected value!");
+
+        // A cell can only back one property.
+        bool attached_twice {true};
+
+        try {
+            object.add_property("CounterAgain", counter);
+        } catch (const std::exception&) {
+            attached_twice = false;
+        }
+
+        if (attached_twice)
+            throw std::runtime_error("A property_cell has been added to two properties!");
+
+        // Objects backed by a cell can come and go while other threads keep storing into it.
+        easydbuspp::property_cell<int> shared_counter {0};
+
+        done = false;
+
+        std::thread busy_writer([&] {
+            for (int i = 1; !done; ++i)
+                shared_counter.store(i);
+        });
+
+        for (int i = 0; i < 50; ++i) {
+            easydbuspp::object transient {obj_session_manager, INTERFACE_NAME, OBJECT_PATH / "Transient"};
+            transient.add_property("Counter", shared_counter, true);
+        }
+
+        done = true;
+        busy_writer.join();
+
+        easydbuspp::main_loop::instance().stop();
+        easydbuspp::main_loop::instance().wait();
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
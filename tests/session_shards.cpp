@@ -0,0 +1,97 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include <chrono>
+#include <easydbuspp.h>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+int main()
+{
+    using namespace std::chrono_literals;
+
+    try {
+        const std::vector<std::string>  BUS_NAMES {"net.test.EasyDBuspp.Shard0", "net.test.EasyDBuspp.Shard1"};
+        const std::string               INTERFACE_NAME {"net.test.EasyDBuspp.TestInterface"};
+        const easydbuspp::object_path_t ROOT_PATH {"/net/test/EasyDBuspp/Objects"};
+
+        // Set up the objects, each on the shard its path maps to.
+        easydbuspp::session_shards service {easydbuspp::bus_type_t::SESSION, BUS_NAMES,
+                                            easydbuspp::dispatch_t::OWN_THREAD};
+
+        std::vector<easydbuspp::object_path_t>           paths;
+        std::vector<std::unique_ptr<easydbuspp::object>> objects;
+
+        for (int i = 0; i < 6; ++i) {
+            auto path = ROOT_PATH / ("o" + std::to_string(i));
+
+            objects.push_back(std::make_unique<easydbuspp::object>(service.for_path(path), INTERFACE_NAME, path));
+            objects.back()->add_method("Path", [path] {
+                return path.generic_string();
+            });
+
+            paths.push_back(path);
+        }
+
+        // Set up the client side, with as many connections.
+        easydbuspp::session_shards clients {easydbuspp::bus_type_t::SESSION, 2, easydbuspp::dispatch_t::OWN_THREAD};
+
+        std::set<std::string> unique_names;
+
+        for (size_t i = 0; i < 2; ++i) {
+            unique_names.insert(service[i].unique_bus_name());
+            unique_names.insert(clients[i].unique_bus_name());
+        }
+
+        if (unique_names.size() != 4)
+            throw std::runtime_error("The shards don't have connections of their own!");
+
+        easydbuspp::org_freedesktop_dbus_proxy dbus_proxy {clients[0]};
+
+        for (auto&& bus_name : BUS_NAMES) {
+            for (int i = 0; !dbus_proxy.call<bool>("NameHasOwner", bus_name); ++i) {
+                if (i == 100)
+                    throw std::runtime_error("Timed out waiting for " + bus_name + "!");
+
+                std::this_thread::sleep_for(50ms);
+            }
+        }
+
+        std::set<size_t> used_shards;
+
+        for (auto&& path : paths) {
+            size_t index = service.index_for(path);
+            used_shards.insert(index);
+
+            easydbuspp::proxy proxy {clients.next(), BUS_NAMES[index], INTERFACE_NAME, path};
+
+            if (proxy.call<std::string>("Path") != path.generic_string())
+                throw std::runtime_error("Unexpected Path() result!");
+
+            // The object is served by its own shard only.
+            easydbuspp::proxy wrong_shard {clients.next(), BUS_NAMES[1 - index], INTERFACE_NAME, path};
+
+            bool threw {false};
+
+            try {
+                wrong_shard.call<std::string>("Path");
+            } catch (const std::runtime_error&) {
+                threw = true;
+            }
+
+            if (!threw)
+                throw std::runtime_error("An object was reachable through the wrong shard!");
+        }
+
+        if (used_shards.size() != 2)
+            throw std::runtime_error("The objects were not spread across the shards!");
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,92 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include <algorithm>
+#include <easydbuspp.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <unistd.h>
+
+int main()
+{
+    try {
+        const std::string               BUS_NAME {"net.test.EasyDBuspp.Test"};
+        const std::string               INTERFACE_NAME {"net.test.EasyDBuspp.TestInterface"};
+        const easydbuspp::object_path_t OBJECT_PATH {"/net/test/EasyDBuspp/TestObject"};
+
+        // Set up an object.
+        easydbuspp::session_manager obj_session_manager {easydbuspp::bus_type_t::SESSION, BUS_NAME};
+        easydbuspp::object          object {obj_session_manager, INTERFACE_NAME, OBJECT_PATH};
+
+        object.add_method("ReverseSharedBuffer", [](const easydbuspp::shared_buffer& buffer) {
+            std::vector<std::byte> reversed(buffer.begin(), buffer.end());
+            std::reverse(reversed.begin(), reversed.end());
+
+            return easydbuspp::shared_buffer {reversed};
+        });
+
+        easydbuspp::main_loop::instance().run_async();
+
+        // Set up a proxy to access the object.
+        easydbuspp::session_manager proxy_session_manager {easydbuspp::bus_type_t::SESSION};
+        easydbuspp::proxy           proxy {proxy_session_manager, BUS_NAME, INTERFACE_NAME, OBJECT_PATH};
+
+        // A few MiB: more than we'd want copied through the bus daemon.
+        std::vector<std::byte> bytes(8 * 1024 * 1024);
+
+        for (size_t i = 0; i < bytes.size(); ++i)
+            bytes[i] = std::byte {static_cast<uint8_t>(i % 251)};
+
+        auto reversed = proxy.call<easydbuspp::shared_buffer>("ReverseSharedBuffer", easydbuspp::shared_buffer {bytes});
+
+        if (reversed.size() != bytes.size() || !std::equal(bytes.rbegin(), bytes.rend(), reversed.begin()))
+            throw std::runtime_error("'ReverseSharedBuffer' did not return the expected value!");
+
+        // Small payloads travel inline, unless asked not to.
+        std::vector<std::byte> small(bytes.begin(), bytes.begin() + 100);
+
+        for (size_t threshold : {easydbuspp::shared_buffer::DEFAULT_INLINE_THRESHOLD, size_t {0}}) {
+            reversed = proxy.call<easydbuspp::shared_buffer>("ReverseSharedBuffer",
+                                                             easydbuspp::shared_buffer {small, threshold});
+
+            if (reversed.size() != small.size() || !std::equal(small.rbegin(), small.rend(), reversed.begin()))
+                throw std::runtime_error("'ReverseSharedBuffer' did not return the expected small value!");
+        }
+
+        if (!proxy.call<easydbuspp::shared_buffer>("ReverseSharedBuffer", easydbuspp::shared_buffer {}).empty())
+            throw std::runtime_error("'ReverseSharedBuffer' did not return an empty buffer!");
+
+        // An fd the sender could still write to is refused (the call fails, and the service keeps going).
+        int unsealed = memfd_create("unsealed", MFD_CLOEXEC);
+
+        if (unsealed < 0 || ftruncate(unsealed, 4096) < 0)
+            throw std::runtime_error("Could not create an unsealed memfd!");
+
+        GDBusConnection* connection = g_bus_get_sync(G_BUS_TYPE_SESSION, nullptr, nullptr);
+        GUnixFDList*     fd_list    = g_unix_fd_list_new_from_array(&unsealed, 1);
+        GError*          error {nullptr};
+
+        GVariant* result = g_dbus_connection_call_with_unix_fd_list_sync(
+            connection, BUS_NAME.c_str(), OBJECT_PATH.c_str(), INTERFACE_NAME.c_str(), "ReverseSharedBuffer",
+            g_variant_new("(v)", g_variant_new_handle(0)), nullptr, G_DBUS_CALL_FLAGS_NONE, -1, fd_list, nullptr,
+            nullptr, &error);
+
+        g_object_unref(fd_list);
+        g_object_unref(connection);
+
+        if (result) {
+            g_variant_unref(result);
+            throw std::runtime_error("'ReverseSharedBuffer' accepted an unsealed memfd!");
+        }
+
+        g_error_free(error);
+
+        easydbuspp::main_loop::instance().stop();
+        easydbuspp::main_loop::instance().wait();
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,183 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include <atomic>
+#include <chrono>
+#include <easydbuspp.h>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+int main()
+{
+    try {
+        const std::string               BUS_NAME {"net.test.EasyDBuspp.Test"};
+        const std::string               INTERFACE_NAME {"net.test.EasyDBuspp.TestInterface"};
+        const easydbuspp::object_path_t OBJECT_PATH {"/net/test/EasyDBuspp/TestObject"};
+        constexpr int                   SIGNAL_COUNT {50};
+
+        // Set up an object.
+        easydbuspp::session_manager obj_session_manager {easydbuspp::bus_type_t::SESSION, BUS_NAME};
+        easydbuspp::object          object {obj_session_manager, INTERFACE_NAME, OBJECT_PATH};
+
+        auto counter_signal = object.add_broadcast_signal<int>("Counter");
+
+        object.add_method("EmitCounterSignals", [&counter_signal] {
+            for (int i = 0; i < SIGNAL_COUNT; ++i)
+                counter_signal(i);
+        });
+
+        object.add_method("Ping", [] {
+            return true;
+        });
+
+        easydbuspp::main_loop::instance().run_async();
+
+        // Set up a proxy to access the object.
+        easydbuspp::session_manager proxy_session_manager {easydbuspp::bus_type_t::SESSION};
+        easydbuspp::proxy           proxy {proxy_session_manager, BUS_NAME, INTERFACE_NAME, OBJECT_PATH};
+
+        std::mutex       mutex;
+        std::thread::id  dispatch_thread;
+        std::vector<int> strand_values, queue_values;
+        std::atomic<int> pool_deliveries {0};
+        bool             off_dispatch_thread {true};
+
+        auto inline_subscription = proxy_session_manager.signal_subscribe("Counter", [&](int) {
+            std::lock_guard lock {mutex};
+            dispatch_thread = std::this_thread::get_id();
+        });
+
+        // Slow enough that handling them all inline would keep the dispatch thread busy for a while.
+        auto strand_subscription = proxy_session_manager.signal_subscribe(
+            "Counter",
+            [&](int value) {
+                std::this_thread::sleep_for(std::chrono::milliseconds {10});
+
+                std::lock_guard lock {mutex};
+                strand_values.push_back(value);
+                off_dispatch_thread = off_dispatch_thread && std::this_thread::get_id() != dispatch_thread;
+            },
+            {}, {}, {}, easydbuspp::signal_delivery_t::STRAND);
+
+        auto queue_subscription = proxy_session_manager.signal_subscribe(
+            "Counter",
+            [&](int value) {
+                std::lock_guard lock {mutex};
+                queue_values.push_back(value);
+            },
+            {}, {}, {}, {easydbuspp::signal_delivery_t::QUEUE, SIGNAL_COUNT});
+
+        auto pool_subscription = proxy_session_manager.signal_subscribe(
+            "Counter",
+            [&pool_deliveries](int) {
+                ++pool_deliveries;
+            },
+            {}, {}, {}, easydbuspp::signal_delivery_t::THREAD_POOL);
+
+        proxy.call<void>("EmitCounterSignals");
+
+        // The dispatch thread must still be responsive while the strand works through the signals.
+        if (!proxy.call<bool>("Ping"))
+            throw std::runtime_error("'Ping' did not return the expected value!");
+
+        {
+            std::lock_guard lock {mutex};
+
+            if (strand_values.size() == SIGNAL_COUNT)
+                throw std::runtime_error("Slow STRAND handler seems to have blocked signal dispatch!");
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds {10};
+
+        for (;;) {
+            {
+                std::lock_guard lock {mutex};
+
+                if (strand_values.size() == SIGNAL_COUNT && queue_values.size() == SIGNAL_COUNT
+                    && pool_deliveries == SIGNAL_COUNT)
+                    break;
+            }
+
+            if (std::chrono::steady_clock::now() > deadline)
+                throw std::runtime_error("Not all signals were delivered!");
+
+            std::this_thread::sleep_for(std::chrono::milliseconds {10});
+        }
+
+        {
+            std::lock_guard lock {mutex};
+
+            for (int i = 0; i < SIGNAL_COUNT; ++i) {
+                if (strand_values[i] != i || queue_values[i] != i)
+                    throw std::runtime_error("STRAND / QUEUE signals were not delivered in order!");
+            }
+
+            if (!off_dispatch_thread)
+                throw std::runtime_error("STRAND handler ran on the dispatch thread!");
+        }
+
+        // Unsubscribing waits for the handler calls that are running, and no more come after it.
+        std::atomic<int>  running {0};
+        std::atomic<bool> unsubscribed {false};
+        std::atomic<bool> late_call {false};
+
+        auto slow_subscription = proxy_session_manager.signal_subscribe(
+            "Counter",
+            [&](int) {
+                if (unsubscribed)
+                    late_call = true;
+
+                ++running;
+                std::this_thread::sleep_for(std::chrono::milliseconds {20});
+                --running;
+            },
+            {}, {}, {}, easydbuspp::signal_delivery_t::THREAD_POOL);
+
+        // A handler may unsubscribe itself.
+        easydbuspp::signal_subscription self_subscription;
+        std::atomic<int>                self_calls {0};
+
+        self_subscription = proxy_session_manager.signal_subscribe(
+            "Counter",
+            [&](int) {
+                ++self_calls;
+                self_subscription.unsubscribe();
+            },
+            {}, {}, {}, easydbuspp::signal_delivery_t::QUEUE);
+
+        proxy.call<void>("EmitCounterSignals");
+
+        deadline = std::chrono::steady_clock::now() + std::chrono::seconds {10};
+
+        while (running == 0 || self_calls == 0) {
+            if (std::chrono::steady_clock::now() > deadline)
+                throw std::runtime_error("The handlers were not called!");
+
+            std::this_thread::sleep_for(std::chrono::milliseconds {1});
+        }
+
+        slow_subscription.unsubscribe();
+        unsubscribed = true;
+
+        if (running != 0)
+            throw std::runtime_error("Unsubscribing did not wait for the running handler calls!");
+
+        std::this_thread::sleep_for(std::chrono::milliseconds {100});
+
+        if (late_call)
+            throw std::runtime_error("A handler was called after unsubscribing!");
+
+        if (self_calls != 1 || self_subscription)
+            throw std::runtime_error("A handler did not unsubscribe itself!");
+
+        easydbuspp::main_loop::instance().stop();
+        easydbuspp::main_loop::instance().wait();
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
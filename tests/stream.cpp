@@ -0,0 +1,83 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include <easydbuspp.h>
+#include <iostream>
+#include <thread>
+
+int main()
+{
+    try {
+        const std::string               BUS_NAME {"net.test.EasyDBuspp.Test"};
+        const std::string               INTERFACE_NAME {"net.test.EasyDBuspp.TestInterface"};
+        const easydbuspp::object_path_t OBJECT_PATH {"/net/test/EasyDBuspp/TestObject"};
+        const size_t                    RECORD_COUNT {100000};
+
+        // Set up an object.
+        easydbuspp::session_manager obj_session_manager {easydbuspp::bus_type_t::SESSION, BUS_NAME};
+        easydbuspp::object          object {obj_session_manager, INTERFACE_NAME, OBJECT_PATH};
+
+        // Returns right away, the records are produced while the caller consumes them.
+        object.add_method("ExportLogs", [RECORD_COUNT] {
+            auto [reader, writer] = easydbuspp::make_stream();
+
+            std::thread {[writer = writer, RECORD_COUNT]() mutable {
+                try {
+                    for (size_t i = 0; i < RECORD_COUNT; ++i)
+                        writer.write("log line " + std::to_string(i));
+                } catch (const std::exception& e) {
+                    std::cerr << "Producer error: " << e.what() << "\n";
+                }
+            }}.detach();
+
+            return reader;
+        });
+
+        easydbuspp::main_loop::instance().run_async();
+
+        // Set up a proxy to access the object.
+        easydbuspp::session_manager proxy_session_manager {easydbuspp::bus_type_t::SESSION};
+        easydbuspp::proxy           proxy {proxy_session_manager, BUS_NAME, INTERFACE_NAME, OBJECT_PATH};
+
+        auto   logs = proxy.call<easydbuspp::stream_reader>("ExportLogs");
+        size_t received {0};
+
+        while (auto record = logs.next()) {
+            if (*record != "log line " + std::to_string(received))
+                throw std::runtime_error("'ExportLogs' streamed an unexpected record!");
+            ++received;
+        }
+
+        if (received != RECORD_COUNT)
+            throw std::runtime_error("'ExportLogs' did not stream the expected number of records!");
+
+        // Records longer than the reader's maximum are refused, rather than allocated.
+        auto [small_reader, writer] = easydbuspp::make_stream();
+
+        small_reader.max_record_size(16);
+        writer.write("short record");
+        writer.write("a record longer than sixteen bytes");
+
+        if (small_reader.next() != "short record")
+            throw std::runtime_error("A record within the maximum size was not read correctly!");
+
+        bool refused {false};
+
+        try {
+            small_reader.next();
+        } catch (const std::runtime_error&) {
+            refused = true;
+        }
+
+        if (!refused)
+            throw std::runtime_error("A record over the maximum size was not refused!");
+
+        easydbuspp::main_loop::instance().stop();
+        easydbuspp::main_loop::instance().wait();
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
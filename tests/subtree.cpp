@@ -0,0 +1,127 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include <easydbuspp.h>
+#include <iostream>
+#include <map>
+#include <mutex>
+
+int main()
+{
+    try {
+        const std::string               BUS_NAME {"net.test.EasyDBuspp.Test"};
+        const std::string               INTERFACE_NAME {"net.test.EasyDBuspp.Device"};
+        const easydbuspp::object_path_t DEVICES_PATH {"/net/test/EasyDBuspp/Devices"};
+        const int                       DEVICE_COUNT {1000000};
+
+        // Children are "dev0" ... "dev999999", none of which exists as an object.
+        auto device_index = [DEVICE_COUNT](const std::string& child) {
+            if (child.compare(0, 3, "dev") != 0 || child.size() == 3
+                || child.find_first_not_of("0123456789", 3) != std::string::npos)
+                return -1;
+
+            int index = std::stoi(child.substr(3));
+            return index < DEVICE_COUNT ? index : -1;
+        };
+
+        std::mutex                 labels_mutex;
+        std::map<int, std::string> labels;
+
+        auto lookup_device = [&device_index](const std::string& child) {
+            return device_index(child) >= 0;
+        };
+
+        // Only used for introspection.
+        auto enumerate_devices = [] {
+            return std::vector<std::string> {"dev0", "dev1", "dev2"};
+        };
+
+        // Set up the subtree.
+        easydbuspp::session_manager obj_session_manager {easydbuspp::bus_type_t::SESSION, BUS_NAME};
+        easydbuspp::object          devices {obj_session_manager, INTERFACE_NAME, DEVICES_PATH, lookup_device,
+                                    enumerate_devices};
+
+        devices.add_method("Name", [](const easydbuspp::dbus_context& context) {
+            return context.object_path.filename().string();
+        });
+
+        devices.add_property<int>(
+            "Index",
+            [&device_index](const easydbuspp::dbus_context& context) {
+                return device_index(context.object_path.filename());
+            },
+            {});
+
+        devices.add_property<std::string>(
+            "Label",
+            [&](const easydbuspp::dbus_context& context) {
+                std::lock_guard lock {labels_mutex};
+                return labels[device_index(context.object_path.filename())];
+            },
+            [&](const easydbuspp::dbus_context& context, const std::string& label) {
+                std::lock_guard lock {labels_mutex};
+                labels[device_index(context.object_path.filename())] = label;
+                return true;
+            });
+
+        easydbuspp::main_loop::instance().run_async();
+
+        // Set up proxies to access a couple of children.
+        const easydbuspp::object_path_t DEV42_PATH {DEVICES_PATH / "dev42"};
+        const easydbuspp::object_path_t DEV999999_PATH {DEVICES_PATH / "dev999999"};
+
+        easydbuspp::session_manager proxy_session_manager {easydbuspp::bus_type_t::SESSION};
+        easydbuspp::proxy           dev42 {proxy_session_manager, BUS_NAME, INTERFACE_NAME, DEV42_PATH};
+        easydbuspp::proxy           dev999999 {proxy_session_manager, BUS_NAME, INTERFACE_NAME, DEV999999_PATH};
+
+        if (dev42.call<std::string>("Name") != "dev42" || dev999999.call<std::string>("Name") != "dev999999")
+            throw std::runtime_error("Method calls did not reach the right children!");
+
+        if (dev42.property<int>("Index") != 42 || dev999999.property<int>("Index") != 999999)
+            throw std::runtime_error("Property reads did not reach the right children!");
+
+        dev42.property("Label", std::string {"Forty-two"});
+
+        if (dev42.property<std::string>("Label") != "Forty-two" || !dev999999.property<std::string>("Label").empty())
+            throw std::runtime_error("Property writes did not reach the right child!");
+
+        // Children the lookup function doesn't know about don't exist.
+        bool exception_caught {false};
+
+        try {
+            easydbuspp::proxy nonexistent {proxy_session_manager, BUS_NAME, INTERFACE_NAME, DEVICES_PATH / "printer"};
+            nonexistent.call<std::string>("Name");
+        } catch (const std::exception&) {
+            exception_caught = true;
+        }
+
+        if (!exception_caught)
+            throw std::runtime_error("Calling a method on a nonexistent child succeeded, and it shouldn't have!");
+
+        // A lookup that throws (std::stoi() overflows here) means the child doesn't exist, too.
+        exception_caught = false;
+
+        try {
+            easydbuspp::proxy overflow {proxy_session_manager, BUS_NAME, INTERFACE_NAME,
+                                        DEVICES_PATH / "dev99999999999999999999"};
+            overflow.call<std::string>("Name");
+        } catch (const std::exception&) {
+            exception_caught = true;
+        }
+
+        if (!exception_caught)
+            throw std::runtime_error("Calling a method on a child whose lookup throws succeeded!");
+
+        // And the service survived it.
+        if (dev42.property<int>("Index") != 42)
+            throw std::runtime_error("The service did not survive a throwing lookup!");
+
+        easydbuspp::main_loop::instance().stop();
+        easydbuspp::main_loop::instance().wait();
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
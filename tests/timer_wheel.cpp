@@ -0,0 +1,77 @@
+// SPDX-FileCopyrightText: © 2024 Răzvan Cojocaru <rzvncj@gmail.com>
+//
+// SPDX-License-Identifier: AGPL-3.0-only
+
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <timer_wheel.h>
+#include <vector>
+
+int main()
+{
+    try {
+        easydbuspp::timer_wheel<size_t> wheel;
+
+        const uint64_t START {1000};
+        const uint64_t HORIZON {300000}; // Spans all four levels.
+        const size_t   TIMERS {5000};
+
+        std::mt19937_64                         rng {42};
+        std::uniform_int_distribution<uint64_t> expiry {START, START + HORIZON};
+
+        std::vector<uint64_t>                                expires(TIMERS);
+        std::vector<uint64_t>                                expired_at(TIMERS, 0);
+        std::vector<easydbuspp::timer_wheel<size_t>::handle> handles(TIMERS);
+
+        wheel.advance(START, [](size_t) {
+        });
+
+        for (size_t i = 0; i < TIMERS; ++i) {
+            expires[i] = expiry(rng);
+            handles[i] = wheel.insert(i, expires[i]);
+        }
+
+        // Every 10th timer is cancelled.
+        for (size_t i = 0; i < TIMERS; i += 10)
+            wheel.erase(handles[i]);
+
+        for (uint64_t now = START + 1; now <= START + HORIZON; ++now)
+            wheel.advance(now, [&](size_t i) {
+                expired_at[i] = now;
+            });
+
+        if (!wheel.empty())
+            throw std::runtime_error(std::to_string(wheel.size()) + " timers never expired!");
+
+        for (size_t i = 0; i < TIMERS; ++i) {
+            if (i % 10 == 0) {
+                if (expired_at[i] != 0)
+                    throw std::runtime_error("Erased timer " + std::to_string(i) + " expired!");
+                continue;
+            }
+
+            if (expired_at[i] != expires[i])
+                throw std::runtime_error("Timer " + std::to_string(i) + " expired on tick "
+                                         + std::to_string(expired_at[i]) + " instead of "
+                                         + std::to_string(expires[i]) + "!");
+        }
+
+        // Big jumps expire everything due on the way.
+        size_t expired {0};
+
+        wheel.insert(0, START + HORIZON + 10);
+        wheel.insert(1, START + HORIZON + 5000);
+        wheel.advance(START + HORIZON + 10000, [&expired](size_t) {
+            ++expired;
+        });
+
+        if (expired != 2)
+            throw std::runtime_error("Advancing past several timers at once did not expire all of them!");
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
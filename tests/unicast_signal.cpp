@@ -31,7 +31,7 @@ int main()
         easydbuspp::org_freedesktop_dbus_proxy dbus_proxy(proxy_session_manager);
         std::string                            unique_bus_name = dbus_proxy.unique_bus_name(BUS_NAME);
 
-        proxy_session_manager.signal_subscribe(
+        auto subscription = proxy_session_manager.signal_subscribe(
             "UnicastSignal",
             [](const std::string& s) {
                 std::cout << "Got signal UnicastSignal: ['" << s << "']" << std::endl;